@@ -2,6 +2,8 @@
 
 int main(int argc, char** argv) {
     App app;
+    if (!app.ParseArgs(argc, argv))
+        return 2;
     return app.Run();
 }
 
@@ -2,6 +2,9 @@
 #include <GLFW/glfw3.h>
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #ifdef max
 #undef max
@@ -29,9 +32,68 @@ App::App()
     g_app = this;
 }
 
+bool App::ParseArgs(int argc, char **argv)
+{
+    bool record = false, replay = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--record") && hasValue)
+        {
+            record = true;
+            m_traceFile = argv[++i];
+        }
+        else if (!std::strcmp(argv[i], "--replay") && hasValue)
+        {
+            replay = true;
+            m_traceFile = argv[++i];
+        }
+        else if (!std::strcmp(argv[i], "--csv") && hasValue)
+        {
+            m_csvFile = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--record <trace> | --replay <trace> [--csv <file>]]\n", argv[0]);
+            return false;
+        }
+    }
+    if (record && replay)
+    {
+        fprintf(stderr, "--record and --replay are exclusive\n");
+        return false;
+    }
+    if (record && !m_trace.StartRecording(m_traceFile.c_str()))
+    {
+        fprintf(stderr, "Cannot write trace %s\n", m_traceFile.c_str());
+        return false;
+    }
+    if (replay && !m_trace.LoadReplay(m_traceFile.c_str()))
+    {
+        fprintf(stderr, "Cannot read trace %s\n", m_traceFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Replays need no display: without one, GLFW's null platform with a
+// surfaceless EGL context (Mesa) stands in for the window system.
+static bool NoDisplay()
+{
+#if defined(__linux__)
+    return !std::getenv("DISPLAY") && !std::getenv("WAYLAND_DISPLAY");
+#else
+    return false;
+#endif
+}
+
 bool App::CreateMainWindow()
 {
     glfwSetErrorCallback(glfw_error_callback);
+#ifdef GLFW_PLATFORM_NULL
+    if (m_trace.Replaying() && NoDisplay())
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
     if (!glfwInit())
         return false;
 
@@ -39,10 +101,28 @@ bool App::CreateMainWindow()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); // 3.2+ only
+    glfwWindowHint(GLFW_DEPTH_BITS, 24); // 3-D surface view
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // Required on Mac
 #endif
 
+    // Replay: hidden window of the recorded size, no vsync
+    if (m_trace.Replaying())
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+        if (glfwGetPlatform() == GLFW_PLATFORM_NULL)
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+        const ImVec2 size = m_trace.InitialSize();
+        m_window = glfwCreateWindow((int)size.x, (int)size.y, m_title.c_str(), nullptr, nullptr);
+        if (m_window == nullptr)
+            return false;
+        glfwMakeContextCurrent(m_window);
+        glfwSwapInterval(0);
+        return true;
+    }
+
     // Get primary monitor for maximized window
     GLFWmonitor *monitor = glfwGetPrimaryMonitor();
     const GLFWvidmode *mode = glfwGetVideoMode(monitor);
@@ -70,6 +150,39 @@ void App::DestroyMainWindow()
     glfwTerminate();
 }
 
+// Replays of one trace must do the same work for their timings to compare:
+// the first replay stores its evaluation count next to the trace and every
+// later one is checked against it.
+bool App::CheckReplayEvaluations() const
+{
+    const std::string file = m_traceFile + ".evals";
+    const long long evals = m_profile.Evaluations();
+    long long expected = -1;
+    if (FILE *f = fopen(file.c_str(), "r"))
+    {
+        if (fscanf(f, "%lld", &expected) != 1)
+            expected = -1;
+        fclose(f);
+    }
+    if (expected < 0)
+    {
+        if (FILE *f = fopen(file.c_str(), "w"))
+        {
+            fprintf(f, "%lld\n", evals);
+            fclose(f);
+        }
+        return true;
+    }
+    if (evals == expected)
+    {
+        printf("evaluations match %s\n", file.c_str());
+        return true;
+    }
+    fprintf(stderr, "Replay did %lld evaluations, %s expects %lld: the runs did different work\n",
+            evals, file.c_str(), expected);
+    return false;
+}
+
 int App::Run()
 {
     if (!CreateMainWindow())
@@ -80,12 +193,28 @@ int App::Run()
         return 1;
     }
 
+    // Replays render offscreen at the recorded framebuffer size
+    if (m_trace.Replaying())
+    {
+        const ImVec2 fb = m_trace.InitialFramebufferSize();
+        if (!m_renderer.SetOffscreen((int)fb.x, (int)fb.y))
+        {
+            fprintf(stderr, "Replay needs OpenGL framebuffer objects\n");
+            m_renderer.Cleanup();
+            DestroyMainWindow();
+            return 1;
+        }
+    }
+
     // ImGui init
     m_gui.Init(m_window, m_renderer);
 
     // Fonts (optional, Cyrillic)
     ImGuiIO &io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard | ImGuiConfigFlags_NavEnableGamepad;
+    // recorded and replayed sessions both start from the default window layout
+    if (m_trace.Recording() || m_trace.Replaying())
+        io.IniFilename = nullptr;
 
     // Cross-platform font loading
     ImFont *font = nullptr;
@@ -129,18 +258,39 @@ int App::Run()
 
     (void)font;
 
-    // Load config, then ensure origin is centered at startup
-    m_cfg.Load("config.ini", m_scene);
-    m_cfg.panX = 0;
-    m_cfg.panY = 0;
+    // Load config, then ensure origin is centered at startup; a replay uses
+    // the config its recording started from
+    const std::string traceConfig = m_traceFile + ".ini";
+    m_cfg.Load(m_trace.Replaying() ? traceConfig.c_str() : "config.ini", m_scene);
+    if (m_trace.Recording())
+    {
+        m_cfg.Save(traceConfig.c_str());
+        std::remove((m_traceFile + ".evals").c_str()); // belongs to the old trace
+    }
+    m_cfg.replaying = m_trace.Replaying();
+    m_scene.SetExpression(m_cfg.funcExpr);
+    m_scene.SetParametric(m_cfg.paramXExpr, m_cfg.paramYExpr);
+    m_scene.SetPolar(m_cfg.polarExpr);
+    m_scene.Implicit().SetExpression(m_cfg.implicitExpr);
+    m_scene.Heatmap().SetExpression(m_cfg.heatmapExpr);
+    m_scene.Surface().SetExpression(m_cfg.surfaceExpr);
+    m_scene.Ode().SetExpression(m_cfg.odeExpr);
+    m_scene.Ode().SetInitialConditions(m_cfg.odeInitial);
+    m_cfg.viewX = 0.0;
+    m_cfg.viewY = 0.0;
 
     // Main loop
     while (!glfwWindowShouldClose(m_window))
     {
+        m_profile.BeginFrame();
         glfwPollEvents();
 
         // Begin GUI frame
-        m_gui.BeginFrame();
+        m_gui.BeginFrame(m_trace);
+        if (m_trace.Replaying())
+            m_renderer.SetOffscreen((int)(io.DisplaySize.x * io.DisplayFramebufferScale.x),
+                                    (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y));
+        m_profile.Mark(STAGE_INPUT);
 
         double now = ImGui::GetTime();
         float dt = (m_prevTime == 0.0) ? 0.0f : float(now - m_prevTime);
@@ -149,57 +299,98 @@ int App::Run()
             dt = 0.1f;
 
         // convert current scale to exponent form (logarithmic zoom space)
-        auto ToExp = [](float scale)
-        { return std::log(scale / 100.0f); };
-        auto FromExp = [](float exp)
-        { return 100.0f * std::exp(exp); };
+        auto ToExp = [](double scale)
+        { return std::log(scale / 100.0); };
+        auto FromExp = [](double exp)
+        { return 100.0 * std::exp(exp); };
+
+        static double zoomExp = ToExp(m_cfg.gridScale); // current exp
+        static double targetExp = zoomExp;              // target exp
+        static double expVel = 0.0;                     // velocity in exp space
+        static double appliedScale = m_cfg.gridScale;   // last scale written by the spring
+        static ImVec2 zoomAnchor = ImVec2(-1.0f, -1.0f); // screen point kept fixed while zooming
+
+        // 0. scale edited elsewhere (View tab, config load): jump there
+        if (m_cfg.gridScale != appliedScale && m_cfg.gridScale > 0.0)
+        {
+            zoomExp = targetExp = ToExp(m_cfg.gridScale);
+            expVel = 0.0;
+        }
 
-        static float zoomExp = ToExp(m_cfg.gridScale); // current exp
-        static float targetExp = zoomExp;              // target exp
-        static float expVel = 0.0f;                    // velocity in exp space
+        // the dashboard replaces both the 2-D plot and the 3-D view
+        const bool dashboard = m_cfg.showDashboard;
+        const bool view3D = !dashboard && m_cfg.viewMode == VIEW_3D;
 
-        // 1. accumulate target from wheel input
-        if (io.MouseWheel != 0.0f)
+        // 1. accumulate target from wheel input (the 3-D view dollies instead)
+        if (io.MouseWheel != 0.0f && !io.WantCaptureMouse && view3D)
         {
-            float step = 0.15f; // 15% per wheel unit
-            targetExp += io.MouseWheel * std::log(1.0f + step);
+            m_cfg.camDistance = std::clamp(m_cfg.camDistance * std::exp(-0.1f * io.MouseWheel), 1.2f, 20.0f);
+        }
+        else if (io.MouseWheel != 0.0f && !io.WantCaptureMouse && !dashboard)
+        {
+            double step = 0.15; // 15% per wheel unit
+            targetExp += io.MouseWheel * std::log(1.0 + step);
+            zoomAnchor = io.MousePos;
         }
 
         // 2. reset on R
-        if (ImGui::IsKeyPressed(ImGuiKey_R))
+        if (ImGui::IsKeyPressed(ImGuiKey_R) && !io.WantTextInput && view3D)
         {
-            targetExp = 0.0f; // exp(0) = 1 → scale=100
-            m_cfg.panX = 0;
-            m_cfg.panY = 0;
+            const AppConfig defaults;
+            m_cfg.camYaw = defaults.camYaw;
+            m_cfg.camPitch = defaults.camPitch;
+            m_cfg.camDistance = defaults.camDistance;
+        }
+        else if (ImGui::IsKeyPressed(ImGuiKey_R) && !io.WantTextInput && !dashboard)
+        {
+            targetExp = 0.0; // exp(0) = 1 → scale=100
+            m_cfg.viewX = 0.0;
+            m_cfg.viewY = 0.0;
+            zoomAnchor = ImVec2(-1.0f, -1.0f);
+        }
+
+        // trace cursor: T toggles, arrows move along a curve (Shift: 10 samples) and across curves
+        if (!view3D && !dashboard && !io.WantTextInput)
+        {
+            if (ImGui::IsKeyPressed(ImGuiKey_T))
+                m_scene.ToggleTrace();
+            if (m_scene.Tracing())
+            {
+                const int step = io.KeyShift ? 10 : 1;
+                if (ImGui::IsKeyPressed(ImGuiKey_LeftArrow)) m_scene.Trace(-step, 0);
+                if (ImGui::IsKeyPressed(ImGuiKey_RightArrow)) m_scene.Trace(step, 0);
+                if (ImGui::IsKeyPressed(ImGuiKey_UpArrow)) m_scene.Trace(0, 1);
+                if (ImGui::IsKeyPressed(ImGuiKey_DownArrow)) m_scene.Trace(0, -1);
+            }
         }
 
         // 3. spring smoothing in exp space
-        const float omega = 12.0f; // responsiveness
-        float x = zoomExp - targetExp;
-        float a = -2.0f * omega * expVel - (omega * omega) * x;
+        const double omega = 12.0; // responsiveness
+        double x = zoomExp - targetExp;
+        double a = -2.0 * omega * expVel - (omega * omega) * x;
         expVel += a * dt;
         zoomExp += expVel * dt;
 
-        // 4. convert back to scale, clamp (avoid std::clamp portability)
-        {
-            float s = FromExp(zoomExp);
-            if (s < 10.0f)
-                s = 10.0f;
-            if (s > 500.0f)
-                s = 500.0f;
-            m_cfg.gridScale = (int)s;
-        }
+        // 4. keep the scale finite; there is no other bound on the zoom
+        const double kMaxExp = 690.0; // ~1e300
+        zoomExp = std::max(-kMaxExp, std::min(kMaxExp, zoomExp));
+        targetExp = std::max(-kMaxExp, std::min(kMaxExp, targetExp));
 
         // snap when close
-        if (fabs(m_cfg.gridScale - FromExp(targetExp)) < 0.01f && fabs(expVel) < 0.01f)
+        if (fabs(zoomExp - targetExp) < 1e-4 && fabs(expVel) < 0.01)
         {
             zoomExp = targetExp;
-            expVel = 0.0f;
-            m_cfg.gridScale = FromExp(targetExp);
+            expVel = 0.0;
         }
+        const double prevUnit = m_cfg.PixelsPerUnit();
+        m_cfg.gridScale = FromExp(zoomExp);
+        appliedScale = m_cfg.gridScale;
 
         // GUI panels
-        m_gui.ShowMainMenu(m_cfg, m_scene);
+        m_profile.Mark(STAGE_VIEW);
+        m_gui.ShowMainMenu(m_cfg, m_scene, m_dashboard);
+        m_gui.ShowSpectrum(m_cfg, m_scene);
+        m_profile.Mark(STAGE_PANELS);
 
         ImVec2 winSize = ImGui::GetIO().DisplaySize;
         // Define plot viewport excluding docked control panel
@@ -222,17 +413,45 @@ int App::Run()
             plotSize.x -= sideWidth;
         }
 
-        ImVec2 center = ImVec2(plotPos.x + plotSize.x * 0.5f, plotPos.y + plotSize.y * 0.5f);
-        center.x += (float)m_cfg.panX;
-        center.y += (float)m_cfg.panY;
+        Viewport vp;
+        vp.plotPos = plotPos;
+        vp.plotSize = plotSize;
+        vp.unit = m_cfg.PixelsPerUnit();
 
-        // Panning with left mouse drag (when UI doesn't capture mouse)
+        // Zoom about the wheel position: the world point under it stays put
+        if (zoomAnchor.x >= 0.0f && prevUnit > 0.0 && vp.unit != prevUnit)
+        {
+            const double ax = zoomAnchor.x - vp.CenterX();
+            const double ay = zoomAnchor.y - vp.CenterY();
+            m_cfg.viewX += ax / prevUnit - ax / vp.unit;
+            m_cfg.viewY -= ay / prevUnit - ay / vp.unit;
+        }
+
+        // Panning with left mouse drag (when UI doesn't capture mouse); orbit in 3-D
         ImGuiIO &iio = ImGui::GetIO();
-        if (iio.MouseDown[ImGuiMouseButton_Left] && !iio.WantCaptureMouse)
+        if (iio.MouseDown[ImGuiMouseButton_Left] && !iio.WantCaptureMouse && view3D)
+        {
+            m_cfg.camYaw -= iio.MouseDelta.x * 0.01f;
+            m_cfg.camPitch = std::clamp(m_cfg.camPitch + iio.MouseDelta.y * 0.01f, -1.5f, 1.5f);
+        }
+        else if (iio.MouseDown[ImGuiMouseButton_Left] && !iio.WantCaptureMouse && !dashboard)
         {
-            m_cfg.panX += (int)iio.MouseDelta.x;
-            m_cfg.panY += (int)iio.MouseDelta.y;
+            m_cfg.viewX -= iio.MouseDelta.x / vp.unit;
+            m_cfg.viewY += iio.MouseDelta.y / vp.unit;
         }
+        // Dashboard panes pan and zoom on their own
+        if (dashboard)
+            m_dashboard.HandleInput(plotPos, plotSize, m_cfg);
+        vp.viewX = m_cfg.viewX;
+        vp.viewY = m_cfg.viewY;
+
+        // Coarse sampling while the view is moving; refine once it settles
+        const bool dragging = iio.MouseDown[ImGuiMouseButton_Left] && !iio.WantCaptureMouse &&
+            (iio.MouseDelta.x != 0.0f || iio.MouseDelta.y != 0.0f);
+        const bool zooming = fabs(expVel) > 1e-3 || fabs(zoomExp - targetExp) > 1e-4;
+        m_scene.SetInteracting(dragging || zooming);
+        if (!zooming)
+            zoomAnchor = ImVec2(-1.0f, -1.0f);
 
         // Build clear color from config
         auto bg = m_cfg.backgroundColor;
@@ -242,28 +461,77 @@ int App::Run()
         float clearA = bg.w;
 
         // Render pass
+        m_profile.Mark(STAGE_VIEW);
         m_renderer.BeginFrame(clearR, clearG, clearB, clearA);
         {
-            // Background layers (grid, axes)
-            m_scene.DrawBackground(plotPos, plotSize, m_cfg);
-            // Function curve
-            m_scene.DrawFunction(center, plotPos, plotSize, m_cfg);
+            if (dashboard)
+            {
+                // Every pane, sampled by one scheduler within the frame budget
+                m_dashboard.Draw(plotPos, plotSize, m_cfg);
+                m_profile.Mark(STAGE_DASHBOARD);
+            }
+            else if (view3D)
+            {
+                // Surface mesh, straight to the framebuffer under the GUI
+                m_scene.Surface().Draw(vp, m_cfg, m_renderer);
+                m_profile.Mark(STAGE_SURFACE);
+            }
+            else
+            {
+                // Field layer below everything else
+                m_scene.Heatmap().Draw(vp, m_cfg, m_renderer);
+                m_profile.Mark(STAGE_HEATMAP);
+                // Background layers (grid, axes)
+                m_scene.DrawBackground(vp, m_cfg);
+                m_profile.Mark(STAGE_GRID);
+                // Function curve
+                m_scene.DrawFunction(vp, m_cfg);
+                m_profile.Mark(STAGE_FUNCTION);
+                // Overlay layers
+                m_scene.Implicit().Draw(vp, m_cfg);
+                m_profile.Mark(STAGE_IMPLICIT);
+                m_scene.Ode().Draw(vp, m_cfg);
+                m_profile.Mark(STAGE_ODE);
+                // Hover readout and trace cursor over all of the above
+                m_scene.DrawReadout(vp, m_cfg);
+                m_profile.Mark(STAGE_READOUT);
+            }
             // ImGui draw
             m_gui.EndFrame(m_renderer);
+            m_profile.Mark(STAGE_IMGUI);
         }
         m_renderer.EndFrame();
 
-        glfwSwapBuffers(m_window);
+        if (!m_trace.Replaying())
+            glfwSwapBuffers(m_window);
+        m_profile.Mark(STAGE_PRESENT);
+        m_profile.EndFrame();
+
+        if (m_trace.Done())
+            glfwSetWindowShouldClose(m_window, GLFW_TRUE);
+    }
+
+    int status = 0;
+    if (m_trace.Replaying() || m_trace.Recording())
+    {
+        printf("%s %s\n", m_trace.Replaying() ? "Replayed" : "Recorded", m_traceFile.c_str());
+        m_profile.Report(stdout);
+        if (!m_csvFile.empty() && !m_profile.WriteCsv(m_csvFile.c_str()))
+            fprintf(stderr, "Cannot write %s\n", m_csvFile.c_str());
     }
+    if (m_trace.Replaying() && !CheckReplayEvaluations())
+        status = 1;
 
-    // Save config on exit
-    m_cfg.Save("config.ini");
+    // Save config on exit; a replay leaves it alone
+    if (!m_trace.Replaying())
+        m_cfg.Save("config.ini");
+    m_trace.Close();
 
     // Shutdown
     m_gui.Shutdown();
     m_renderer.Cleanup();
     DestroyMainWindow();
-    return 0;
+    return status;
 }
 
 void App::OnResize(int w, int h)
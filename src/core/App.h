@@ -2,7 +2,14 @@
 #include "render/RendererGL.h"
 #include "ui/GuiManager.h"
 #include "render/Scene.h"
+#include "render/ImplicitLayer.h"
+#include "render/HeatmapLayer.h"
+#include "render/SurfaceView.h"
+#include "render/OdeLayer.h"
+#include "render/Dashboard.h"
 #include "core/Config.h"
+#include "core/InputTrace.h"
+#include "core/FrameProfile.h"
 #include "Animation.h"
 
 struct GLFWwindow;
@@ -10,6 +17,8 @@ struct GLFWwindow;
 class App {
 public:
     App();
+    // --record <trace> | --replay <trace> [--csv <file>]; false on bad usage.
+    bool ParseArgs(int argc, char** argv);
     int Run();
 
     void OnResize(int w, int h);
@@ -17,6 +26,7 @@ public:
 private:
     bool CreateMainWindow();
     void DestroyMainWindow();
+    bool CheckReplayEvaluations() const;
 
 private:
     GLFWwindow* m_window = nullptr;
@@ -25,9 +35,18 @@ private:
     RendererGL m_renderer;
     GuiManager  m_gui;
     Scene       m_scene;
+    Dashboard   m_dashboard;
     AppConfig   m_cfg;
     ScaleAnimation m_scaleAnim;
 
+    // Input recording, or deterministic replay in a hidden window with a
+    // frame-time report at the end. The trace's config is kept in <trace>.ini
+    // and the first replay's evaluation count in <trace>.evals.
+    InputTrace   m_trace;
+    FrameProfile m_profile;
+    std::string  m_traceFile;
+    std::string  m_csvFile;
+
     float  m_targetScale = 100.0f;
     float m_scaleVel = 0.0f;
     double m_prevTime = 0.0;
@@ -2,10 +2,15 @@
 #include <sstream>
 #include <limits>
 #include <cstring>
+#include <cstdio>
 #include <algorithm>
 #include <iomanip>
 #include "Config.h"
 #include "render/Scene.h"
+#include "render/ImplicitLayer.h"
+#include "render/HeatmapLayer.h"
+#include "render/SurfaceView.h"
+#include "render/OdeLayer.h"
 
 static inline bool starts_with(const std::string& s, const char* p) {
     return s.rfind(p, 0) == 0;
@@ -29,6 +34,31 @@ static inline bool read_vec4(std::istream& is, ImVec4& c) {
     return static_cast<bool>(is >> c.x >> c.y >> c.z >> c.w);
 }
 
+// rest of the line into a fixed expression buffer; false if it was empty
+static inline bool read_expr(std::istringstream& iss, char* buf, int bufSize) {
+    std::string expr; std::getline(iss, expr);
+    if (!expr.empty() && expr[0] == ' ') expr.erase(0, 1);
+    trim_inplace(expr);
+    if (expr.empty()) return false;
+#ifdef _MSC_VER
+    strncpy_s(buf, bufSize, expr.c_str(), _TRUNCATE);
+#else
+    std::strncpy(buf, expr.c_str(), bufSize - 1);
+    buf[bufSize - 1] = '\0';
+#endif
+    return true;
+}
+
+std::vector<DashboardPane> AppConfig::DefaultPanes() {
+    std::vector<DashboardPane> panes;
+    for (const char* e : { "sin(x)", "cos(x)*exp(-x^2/40)", "x^2/10 - 3", "tan(x)" }) {
+        DashboardPane p;
+        std::snprintf(p.expr, sizeof(p.expr), "%s", e);
+        panes.push_back(p);
+    }
+    return panes;
+}
+
 // ---------- Load ----------
 bool AppConfig::Load(const char* file, Scene& scene) {
     std::ifstream f(file);
@@ -41,6 +71,7 @@ bool AppConfig::Load(const char* file, Scene& scene) {
 
     if (starts_with(first, "AppConfig")) {
         // new KV format
+        bool panesLoaded = false;
         while (true) {
             if (!std::getline(f, line)) break;
             trim_inplace(line);
@@ -55,33 +86,84 @@ bool AppConfig::Load(const char* file, Scene& scene) {
             else if (key == "backgroundColor") { read_vec4(iss, backgroundColor); }
             else if (key == "quadColor") { read_vec4(iss, quadColor); }
             else if (key == "quadBorderColor") { read_vec4(iss, quadBorderColor); }
+            else if (key == "implicitColor") { read_vec4(iss, implicitColor); }
+            else if (key == "surfaceColor") { read_vec4(iss, surfaceColor); }
+            else if (key == "odeColor") { read_vec4(iss, odeColor); }
+            else if (key == "slopeColor") { read_vec4(iss, slopeColor); }
 
             else if (key == "samples") { iss >> samples; }
+            else if (key == "frameBudgetMs") { iss >> frameBudgetMs; }
+            else if (key == "refineTolerancePx") { iss >> refineTolerancePx; }
             else if (key == "gridSpacing") { iss >> gridSpacing; }
-            else if (key == "gridScale") { iss >> gridScale; }
+            else if (key == "gridScale") { iss >> gridScale; if (!(gridScale > 0.0)) gridScale = 100.0; }
 
             else if (key == "sampleDomainMode") { iss >> sampleDomainMode; }
+            else if (key == "precisionMode") { iss >> precisionMode; }
+            else if (key == "curveMode") { iss >> curveMode; }
+            else if (key == "tMin") { iss >> tMin; }
+            else if (key == "tMax") { iss >> tMax; }
+            else if (key == "showImplicit") { parse_bool(iss, showImplicit); }
+            else if (key == "showHeatmap") { parse_bool(iss, showHeatmap); }
+            else if (key == "heatmapPixel") { iss >> heatmapPixel; }
+            else if (key == "heatmapColormap") { iss >> heatmapColormap; }
+            else if (key == "heatmapAlpha") { iss >> heatmapAlpha; }
+            else if (key == "heatmapAutoRange") { parse_bool(iss, heatmapAutoRange); }
+            else if (key == "heatmapMin") { iss >> heatmapMin; }
+            else if (key == "heatmapMax") { iss >> heatmapMax; }
+            else if (key == "showOde") { parse_bool(iss, showOde); }
+            else if (key == "showSlopeField") { parse_bool(iss, showSlopeField); }
+            else if (key == "slopeSpacingPx") { iss >> slopeSpacingPx; }
+            else if (key == "showSpectrum") { parse_bool(iss, showSpectrum); }
+            else if (key == "spectrumWindow") { iss >> spectrumWindow; }
+            else if (key == "spectrumLogScale") { parse_bool(iss, spectrumLogScale); }
+            else if (key == "spectrumShowPhase") { parse_bool(iss, spectrumShowPhase); }
+            else if (key == "spectrumRange") { iss >> spectrumRange; }
+            else if (key == "chebyshevProxy") { parse_bool(iss, chebyshevProxy); }
+            else if (key == "proxyTolerancePx") { iss >> proxyTolerancePx; }
+            else if (key == "showReadout") { parse_bool(iss, showReadout); }
+            else if (key == "readoutRadiusPx") { iss >> readoutRadiusPx; }
+            else if (key == "viewMode") { iss >> viewMode; }
+            else if (key == "camYaw") { iss >> camYaw; }
+            else if (key == "camPitch") { iss >> camPitch; }
+            else if (key == "camDistance") { iss >> camDistance; }
+            else if (key == "surfaceHeight") { iss >> surfaceHeight; }
+            else if (key == "surfaceDetailPx") { iss >> surfaceDetailPx; }
 
             else if (key == "panelLocation") { iss >> panelLocation; }
-            else if (key == "panX") { iss >> panX; }
-            else if (key == "panY") { iss >> panY; }
+            else if (key == "viewX") { iss >> viewX; }
+            else if (key == "viewY") { iss >> viewY; }
 
             else if (key == "funcExpr") {
-                std::string expr; std::getline(iss, expr);
-                if (!expr.empty() && expr[0] == ' ') expr.erase(0, 1);
-                trim_inplace(expr);
-                if (!expr.empty()) {
-#ifdef _MSC_VER
-                    strncpy_s(funcExpr, kExprBufSize, expr.c_str(), _TRUNCATE);
-#else
-                    std::strncpy(funcExpr, expr.c_str(), kExprBufSize - 1);
-                    funcExpr[kExprBufSize - 1] = '\0';
-#endif
-                    scene.SetExpression(expr);
-                }
+                if (read_expr(iss, funcExpr, kExprBufSize)) scene.SetExpression(funcExpr);
+            }
+            else if (key == "paramXExpr") { read_expr(iss, paramXExpr, kExprBufSize); }
+            else if (key == "paramYExpr") { read_expr(iss, paramYExpr, kExprBufSize); }
+            else if (key == "polarExpr") { read_expr(iss, polarExpr, kExprBufSize); }
+            else if (key == "implicitExpr") { read_expr(iss, implicitExpr, kExprBufSize); }
+            else if (key == "heatmapExpr") { read_expr(iss, heatmapExpr, kExprBufSize); }
+            else if (key == "surfaceExpr") { read_expr(iss, surfaceExpr, kExprBufSize); }
+            else if (key == "odeExpr") { read_expr(iss, odeExpr, kExprBufSize); }
+            else if (key == "odeInitial") { read_expr(iss, odeInitial, kExprBufSize); }
+            else if (key == "showDashboard") { parse_bool(iss, showDashboard); }
+            else if (key == "dashboardColumns") { iss >> dashboardColumns; }
+            else if (key == "dashboardLinked") { parse_bool(iss, dashboardLinked); }
+            else if (key == "dashboardPane") {
+                // the first pane of a file replaces the default set
+                if (!panesLoaded) panes.clear();
+                panesLoaded = true;
+                DashboardPane p;
+                if ((iss >> p.viewX >> p.viewY >> p.spanX) && read_expr(iss, p.expr, (int)sizeof(p.expr)))
+                    panes.push_back(p);
             }
             // unknown keys are ignored for forward compatibility
         }
+        scene.SetParametric(paramXExpr, paramYExpr);
+        scene.SetPolar(polarExpr);
+        scene.Implicit().SetExpression(implicitExpr);
+        scene.Heatmap().SetExpression(heatmapExpr);
+        scene.Surface().SetExpression(surfaceExpr);
+        scene.Ode().SetExpression(odeExpr);
+        scene.Ode().SetInitialConditions(odeInitial);
         return true;
     }
 
@@ -135,14 +217,70 @@ void AppConfig::Save(const char* file) const {
     dump4("backgroundColor", backgroundColor);
     dump4("quadColor", quadColor);
     dump4("quadBorderColor", quadBorderColor);
+    dump4("implicitColor", implicitColor);
+    dump4("surfaceColor", surfaceColor);
+    dump4("odeColor", odeColor);
+    dump4("slopeColor", slopeColor);
     f << "samples " << samples << "\n";
+    f << "frameBudgetMs " << frameBudgetMs << "\n";
+    f << "refineTolerancePx " << refineTolerancePx << "\n";
     f << "gridSpacing " << gridSpacing << "\n";
-    f << "gridScale " << gridScale << "\n";
     f << "sampleDomainMode " << sampleDomainMode << "\n";
+    f << "precisionMode " << precisionMode << "\n";
+    f << "curveMode " << curveMode << "\n";
+    f << "showImplicit " << (showImplicit ? 1 : 0) << "\n";
+    f << "showHeatmap " << (showHeatmap ? 1 : 0) << "\n";
+    f << "heatmapPixel " << heatmapPixel << "\n";
+    f << "heatmapColormap " << heatmapColormap << "\n";
+    f << "heatmapAlpha " << heatmapAlpha << "\n";
+    f << "heatmapAutoRange " << (heatmapAutoRange ? 1 : 0) << "\n";
+    f << "heatmapMin " << heatmapMin << "\n";
+    f << "heatmapMax " << heatmapMax << "\n";
+    f << "showOde " << (showOde ? 1 : 0) << "\n";
+    f << "showSlopeField " << (showSlopeField ? 1 : 0) << "\n";
+    f << "slopeSpacingPx " << slopeSpacingPx << "\n";
+    f << "showSpectrum " << (showSpectrum ? 1 : 0) << "\n";
+    f << "spectrumWindow " << spectrumWindow << "\n";
+    f << "spectrumLogScale " << (spectrumLogScale ? 1 : 0) << "\n";
+    f << "spectrumShowPhase " << (spectrumShowPhase ? 1 : 0) << "\n";
+    f << "spectrumRange " << spectrumRange << "\n";
+    f << "chebyshevProxy " << (chebyshevProxy ? 1 : 0) << "\n";
+    f << "proxyTolerancePx " << proxyTolerancePx << "\n";
+    f << "showReadout " << (showReadout ? 1 : 0) << "\n";
+    f << "readoutRadiusPx " << readoutRadiusPx << "\n";
+    f << "viewMode " << viewMode << "\n";
+    f << "camYaw " << camYaw << "\n";
+    f << "camPitch " << camPitch << "\n";
+    f << "camDistance " << camDistance << "\n";
+    f << "surfaceHeight " << surfaceHeight << "\n";
+    f << "surfaceDetailPx " << surfaceDetailPx << "\n";
     f << "panelLocation " << panelLocation << "\n";
-    f << "panX " << panX << "\n";
-    f << "panY " << panY << "\n";
+    f << "showDashboard " << (showDashboard ? 1 : 0) << "\n";
+    f << "dashboardColumns " << dashboardColumns << "\n";
+    f << "dashboardLinked " << (dashboardLinked ? 1 : 0) << "\n";
+
+    // view state needs full double precision to survive deep zoom
+    f << std::scientific << std::setprecision(17);
+    f << "gridScale " << gridScale << "\n";
+    f << "viewX " << viewX << "\n";
+    f << "viewY " << viewY << "\n";
+    f << "tMin " << tMin << "\n";
+    f << "tMax " << tMax << "\n";
+    f << std::fixed << std::setprecision(6);
 
     // expr — остаток строки, без кавычек
     f << "funcExpr " << funcExpr << "\n";
+    f << "paramXExpr " << paramXExpr << "\n";
+    f << "paramYExpr " << paramYExpr << "\n";
+    f << "polarExpr " << polarExpr << "\n";
+    f << "implicitExpr " << implicitExpr << "\n";
+    f << "heatmapExpr " << heatmapExpr << "\n";
+    f << "surfaceExpr " << surfaceExpr << "\n";
+    f << "odeExpr " << odeExpr << "\n";
+    f << "odeInitial " << odeInitial << "\n";
+
+    // dashboardPane <viewX> <viewY> <spanX> <expr>
+    f << std::scientific << std::setprecision(17);
+    for (const DashboardPane& p : panes)
+        f << "dashboardPane " << p.viewX << " " << p.viewY << " " << p.spanX << " " << p.expr << "\n";
 }
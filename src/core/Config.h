@@ -1,12 +1,37 @@
 #pragma once
 #include <imgui.h>
 #include <string>
+#include <vector>
 
 enum SampleDomainMode {
     SAMPLE_DOMAIN_SYMMETRIC = 0,  // [-T/2, +T/2]
     SAMPLE_DOMAIN_CAUSAL          // [0, T]
 };
 
+enum CurveMode {
+    CURVE_EXPLICIT = 0,           // y = f(x)
+    CURVE_PARAMETRIC,             // (x(t), y(t))
+    CURVE_POLAR                   // r(theta)
+};
+
+enum EvalPrecision {
+    PRECISION_AUTO = 0,           // cheapest type that resolves the current view
+    PRECISION_FLOAT,
+    PRECISION_DOUBLE,
+    PRECISION_LONG_DOUBLE
+};
+
+enum ViewMode {
+    VIEW_2D = 0,
+    VIEW_3D                       // rotatable surface z = f(x, y)
+};
+
+enum HeatmapColormap {
+    HEATMAP_VIRIDIS = 0,
+    HEATMAP_COOLWARM,
+    HEATMAP_GRAY
+};
+
 enum PanelDockLocation {
     PANEL_TOP = 0,
     PANEL_LEFT,
@@ -16,6 +41,13 @@ enum PanelDockLocation {
 
 class Scene;
 
+// One plot of the dashboard: y = f(x) with a view of its own.
+struct DashboardPane {
+    char expr[256] = "sin(x)";
+    double viewX = 0.0, viewY = 0.0; // world point at the pane center
+    double spanX = 20.0;             // world width across the pane
+};
+
 struct AppConfig {
     ImVec4 funcColor = ImVec4(80 / 255.f, 160 / 255.f, 255 / 255.f, 255 / 255.f);
     ImVec4 gridColor = ImVec4(0, 0, 0, 0.24f);
@@ -23,26 +55,86 @@ struct AppConfig {
     ImVec4 backgroundColor = ImVec4(1, 1, 1, 1);
     ImVec4 quadColor = ImVec4(1, 0, 1, 0.25f);
     ImVec4 quadBorderColor = ImVec4(0, 0, 1, 0.8f);
+    ImVec4 implicitColor = ImVec4(0.85f, 0.25f, 0.1f, 1.0f);
+    ImVec4 surfaceColor = ImVec4(0.35f, 0.6f, 0.9f, 1.0f);
+    ImVec4 odeColor = ImVec4(0.1f, 0.55f, 0.2f, 1.0f);
+    ImVec4 slopeColor = ImVec4(0.3f, 0.3f, 0.3f, 0.6f);
 
     int   samples = 500;
+    float frameBudgetMs = 4.0f;     // evaluation time allowed per frame
+    float refineTolerancePx = 0.25f; // stop refining once midpoints move less than this
     int   gridSpacing = 50;
-    int gridScale = 100;
+    double gridScale = 100.0;       // percent, logarithmic zoom without bounds
 
     int sampleDomainMode = SAMPLE_DOMAIN_SYMMETRIC;
+    int precisionMode = PRECISION_AUTO;
+    int curveMode = CURVE_EXPLICIT;
+    double tMin = 0.0;              // parameter range of parametric/polar curves
+    double tMax = 6.283185307179586;
+
+    bool showImplicit = false;      // f(x, y) = 0 contour layer
+    bool showHeatmap = false;       // colormapped z = f(x, y) behind the grid
+    float heatmapPixel = 2.0f;      // on-screen size of one field sample, px
+    int heatmapColormap = HEATMAP_VIRIDIS;
+    float heatmapAlpha = 0.85f;
+    bool heatmapAutoRange = true;   // fit the colormap to the visible values
+    float heatmapMin = -1.0f;
+    float heatmapMax = 1.0f;
+    bool showOde = false;           // solutions of y' = f(x, y)
+    bool showSlopeField = true;
+    float slopeSpacingPx = 32.0f;   // slope field arrows at least this far apart
+
+    bool showSpectrum = false;      // FFT of the explicit function's samples
+    int spectrumWindow = 1;         // SpectrumWindow, Hann by default
+    bool spectrumLogScale = true;   // magnitude in dB
+    bool spectrumShowPhase = false;
+    float spectrumRange = 1.0f;     // fraction of the Nyquist range shown
+
+    bool chebyshevProxy = false;    // resample y = f(x) from piecewise Chebyshev fits
+    float proxyTolerancePx = 0.01f; // largest proxy error allowed on screen
+
+    bool showReadout = true;        // tooltip with the exact sample nearest the mouse
+    float readoutRadiusPx = 12.0f;  // how far from the mouse a sample is picked up
+
+    bool showDashboard = false;     // grid of small plots instead of the main plot
+    int dashboardColumns = 0;       // 0 picks a column count from the pane count and plot shape
+    bool dashboardLinked = false;   // pan and zoom move every pane together
+    std::vector<DashboardPane> panes = DefaultPanes();
+
+    int viewMode = VIEW_2D;
+    float camYaw = -0.9f;           // orbit camera of the 3-D view, radians
+    float camPitch = 0.6f;
+    float camDistance = 3.5f;       // in units of the half domain
+    float surfaceHeight = 0.5f;     // box half-height the z range is fitted to
+    float surfaceDetailPx = 8.0f;   // target on-screen size of one mesh quad
 
     int panelLocation = PANEL_RIGHT;
 
-    int panX = 0; // pixels
-    int panY = 0; // pixels
+    double viewX = 0.0; // world x at plot center
+    double viewY = 0.0; // world y at plot center
+
+    bool replaying = false; // set for --replay, never saved: budgets assume a fixed cost
+
+    double PixelsPerUnit() const { return gridSpacing * (gridScale / 100.0); }
 
     static constexpr int kExprBufSize = 512; 
     char funcExpr[512] = "x"; 
+    char paramXExpr[512] = "cos(3*t)";
+    char paramYExpr[512] = "sin(2*t)";
+    char polarExpr[512] = "cos(4*t)";
+    char implicitExpr[512] = "x^2 + y^2 - 1";
+    char heatmapExpr[512] = "sin(x)*cos(y)";
+    char surfaceExpr[512] = "sin(x)*cos(y)";
+    char odeExpr[512] = "x - y^2";
+    char odeInitial[512] = "0, 0; 0, 1; 0, -0.5; -2, 1";
 
     // helpers for ImGui::InputText
     char* funcExprBuf() { return funcExpr; }
     const char* funcExprBuf() const { return funcExpr; }
     int funcExprBufSize() const { return kExprBufSize; }
 
+    static std::vector<DashboardPane> DefaultPanes();
+
     bool Load(const char* file, Scene& scene);
     void Save(const char* file) const;
 };
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "Fft.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#ifdef HAVE_FFTW
+#include <fftw3.h>
+#endif
+
+#ifdef HAVE_FFTW
+
+struct RealFft::Impl {
+    double* in = nullptr;
+    fftw_complex* out = nullptr;
+    fftw_plan plan = nullptr;
+};
+
+RealFft::RealFft(int n) : impl(std::make_unique<Impl>()), m_n(n) {
+    impl->in = fftw_alloc_real(n);
+    impl->out = fftw_alloc_complex(n / 2 + 1);
+    impl->plan = fftw_plan_dft_r2c_1d(n, impl->in, impl->out, FFTW_ESTIMATE);
+}
+
+RealFft::~RealFft() {
+    fftw_destroy_plan(impl->plan);
+    fftw_free(impl->in);
+    fftw_free(impl->out);
+}
+
+void RealFft::Forward(const std::vector<double>& in, std::vector<std::complex<double>>& out) {
+    std::copy(in.begin(), in.begin() + m_n, impl->in);
+    fftw_execute(impl->plan);
+    out.resize(m_n / 2 + 1);
+    for (int k = 0; k <= m_n / 2; ++k) out[k] = { impl->out[k][0], impl->out[k][1] };
+}
+
+const char* RealFft::Backend() { return "FFTW"; }
+
+#else
+
+struct RealFft::Impl {
+    int m = 0;                                  // complex size n/2
+    std::vector<int> rev;                       // bit-reversal permutation of m
+    std::vector<std::complex<double>> w;        // exp(-2 pi i j / m), j < m/2
+    std::vector<std::complex<double>> split;    // exp(-2 pi i k / n), k <= m
+    std::vector<std::complex<double>> z;
+};
+
+RealFft::RealFft(int n) : impl(std::make_unique<Impl>()), m_n(n) {
+    const int m = n / 2;
+    impl->m = m;
+    impl->rev.resize(m);
+    int bits = 0;
+    while ((1 << bits) < m) ++bits;
+    for (int i = 0; i < m; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        impl->rev[i] = r;
+    }
+    const double pi = 3.14159265358979323846;
+    impl->w.resize(std::max(m / 2, 1));
+    for (int j = 0; j < m / 2; ++j) impl->w[j] = std::polar(1.0, -2.0 * pi * j / m);
+    impl->split.resize(m + 1);
+    for (int k = 0; k <= m; ++k) impl->split[k] = std::polar(1.0, -2.0 * pi * k / n);
+}
+
+RealFft::~RealFft() = default;
+
+void RealFft::Forward(const std::vector<double>& in, std::vector<std::complex<double>>& out) {
+    const int m = impl->m;
+    std::vector<std::complex<double>>& z = impl->z;
+    z.resize(m);
+
+    // even samples in the real part, odd ones in the imaginary part
+    for (int i = 0; i < m; ++i) z[impl->rev[i]] = { in[2 * i], in[2 * i + 1] };
+
+    // iterative radix-2 butterflies
+    for (int len = 2; len <= m; len <<= 1) {
+        const int half = len >> 1, step = m / len;
+        for (int s = 0; s < m; s += len) {
+            for (int j = 0; j < half; ++j) {
+                const std::complex<double> t = impl->w[j * step] * z[s + j + half];
+                z[s + j + half] = z[s + j] - t;
+                z[s + j] += t;
+            }
+        }
+    }
+
+    // X[k] = E[k] + e^(-2 pi i k / n) O[k], with E and O recovered from Z
+    out.resize(m + 1);
+    for (int k = 0; k <= m; ++k) {
+        const std::complex<double> a = z[k % m];
+        const std::complex<double> b = std::conj(z[(m - k) % m]);
+        const std::complex<double> even = 0.5 * (a + b);
+        const std::complex<double> odd = std::complex<double>(0.0, -0.5) * (a - b);
+        out[k] = even + impl->split[k] * odd;
+    }
+}
+
+const char* RealFft::Backend() { return "built-in radix-2"; }
+
+#endif
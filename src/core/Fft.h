@@ -0,0 +1,26 @@
+#pragma once
+#include <complex>
+#include <memory>
+#include <vector>
+
+// Forward real FFT of a fixed power-of-two size. The built-in backend packs
+// the n real inputs into an n/2-point complex radix-2 transform and splits
+// the result; with HAVE_FFTW the transform is an FFTW r2c plan instead.
+// Not thread-safe: use one instance per thread.
+class RealFft {
+public:
+    explicit RealFft(int n);
+    ~RealFft();
+
+    int Size() const { return m_n; }
+    // in: n samples; out: bins 0..n/2 (resized to n/2 + 1).
+    void Forward(const std::vector<double>& in, std::vector<std::complex<double>>& out);
+
+    static const char* Backend();
+    static bool IsPowerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+    int m_n = 0;
+};
@@ -0,0 +1,88 @@
+#include "FrameProfile.h"
+#include <algorithm>
+#include <cmath>
+
+static const char* kStageNames[STAGE_COUNT] = {
+    "input", "view", "panels", "surface", "heatmap", "grid",
+    "function", "implicit", "ode", "readout", "dashboard", "imgui", "present"
+};
+
+std::atomic<long long> FrameProfile::s_evaluations{ 0 };
+
+static float Ms(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<float, std::milli>(d).count();
+}
+
+// Nearest-rank percentile of sorted values.
+static float Percentile(const std::vector<float>& sorted, double p) {
+    if (sorted.empty()) return 0.0f;
+    const size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::clamp(rank, (size_t)1, sorted.size()) - 1];
+}
+
+void FrameProfile::BeginFrame() {
+    m_frameStart = m_last = Clock::now();
+    m_current = Frame();
+}
+
+void FrameProfile::Mark(FrameStage stage) {
+    const Clock::time_point now = Clock::now();
+    m_current.ms[stage] += Ms(now - m_last);
+    m_last = now;
+}
+
+void FrameProfile::EndFrame() {
+    m_current.total = Ms(Clock::now() - m_frameStart);
+    m_current.evals = s_evaluations.exchange(0);
+    m_frames.push_back(m_current);
+}
+
+void FrameProfile::AddEvaluations(long long n) {
+    s_evaluations.fetch_add(n, std::memory_order_relaxed);
+}
+
+long long FrameProfile::Evaluations() const {
+    long long n = 0;
+    for (const Frame& f : m_frames) n += f.evals;
+    return n;
+}
+
+void FrameProfile::Report(FILE* out) const {
+    if (m_frames.empty()) return;
+    std::vector<float> v(m_frames.size());
+    auto column = [&](int stage) {
+        for (size_t i = 0; i < m_frames.size(); ++i)
+            v[i] = stage < 0 ? m_frames[i].total : m_frames[i].ms[stage];
+        std::sort(v.begin(), v.end());
+        double sum = 0.0;
+        for (float x : v) sum += x;
+        return sum / v.size();
+    };
+
+    const double meanTotal = column(-1);
+    std::fprintf(out, "%zu frames, %.3f ms mean (%.1f FPS)\n", m_frames.size(), meanTotal, 1000.0 / meanTotal);
+    std::fprintf(out, "frame ms   p50 %.3f  p90 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+        Percentile(v, 50), Percentile(v, 90), Percentile(v, 95), Percentile(v, 99), v.back());
+    std::fprintf(out, "evaluations %lld (%.0f per frame)\n", Evaluations(), (double)Evaluations() / m_frames.size());
+    std::fprintf(out, "%-10s %8s %8s %8s %8s %7s\n", "stage", "mean", "p50", "p99", "max", "share");
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        const double mean = column(s);
+        std::fprintf(out, "%-10s %8.3f %8.3f %8.3f %8.3f %6.1f%%\n", kStageNames[s], mean,
+            Percentile(v, 50), Percentile(v, 99), v.back(), meanTotal > 0.0 ? 100.0 * mean / meanTotal : 0.0);
+    }
+}
+
+bool FrameProfile::WriteCsv(const char* file) const {
+    FILE* f = std::fopen(file, "w");
+    if (!f) return false;
+    std::fprintf(f, "frame,total");
+    for (const char* name : kStageNames) std::fprintf(f, ",%s", name);
+    std::fprintf(f, ",evals\n");
+    for (size_t i = 0; i < m_frames.size(); ++i) {
+        std::fprintf(f, "%zu,%.4f", i, m_frames[i].total);
+        for (float ms : m_frames[i].ms) std::fprintf(f, ",%.4f", ms);
+        std::fprintf(f, ",%lld\n", m_frames[i].evals);
+    }
+    std::fclose(f);
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Stages of one App::Run frame, in the order they run.
+enum FrameStage {
+    STAGE_INPUT = 0,    // event poll and GUI NewFrame
+    STAGE_VIEW,         // zoom spring, pan, keys
+    STAGE_PANELS,       // control bar and spectrum window
+    STAGE_SURFACE,
+    STAGE_HEATMAP,
+    STAGE_GRID,
+    STAGE_FUNCTION,
+    STAGE_IMPLICIT,
+    STAGE_ODE,
+    STAGE_READOUT,
+    STAGE_DASHBOARD,    // scheduling and drawing the dashboard panes
+    STAGE_IMGUI,        // ImGui render and draw data submission
+    STAGE_PRESENT,      // swap, or waiting for the GPU when offscreen
+    STAGE_COUNT
+};
+
+// Wall time per stage for every frame of a run. Mark(stage) charges the time
+// since the previous mark to that stage, so a frame costs a dozen clock
+// reads. The report gives frame-time percentiles, each stage's share and the
+// expression evaluations done, which replays of one trace must agree on.
+class FrameProfile {
+public:
+    void BeginFrame();
+    void Mark(FrameStage stage);
+    void EndFrame();
+    // Budgeted expression evaluations, added by the layers from any thread
+    // and charged to the frame in progress.
+    static void AddEvaluations(long long n);
+
+    size_t Frames() const { return m_frames.size(); }
+    long long Evaluations() const;
+    void Report(FILE* out) const;
+    // One row per frame: total and every stage in milliseconds, then evaluations.
+    bool WriteCsv(const char* file) const;
+
+private:
+    struct Frame {
+        float ms[STAGE_COUNT] = {};
+        float total = 0.0f;
+        long long evals = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point m_frameStart, m_last;
+    Frame m_current;
+    std::vector<Frame> m_frames;
+    static std::atomic<long long> s_evaluations;
+};
@@ -0,0 +1,157 @@
+#include "InputTrace.h"
+#include <cfloat>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+// One line per frame,
+//   f <dt> <w> <h> <fbScaleX> <fbScaleY> <mouseX|none> <mouseY|none> <buttons> <wheelX> <wheelY> <mods>
+// followed by its key transitions "k <name> <0|1>" and characters "c <codepoint>".
+// Keys are stored by ImGui name so a trace survives ImGui's enum renumbering.
+static const char* kHeader = "FunctionPlotter input trace 1";
+
+// Keys replayed through AddKeyEvent: mouse aliases are implied by the mouse
+// events and modifiers travel as ImGuiMod_* flags.
+static bool Replayable(ImGuiKey key) {
+    if (key >= ImGuiKey_MouseLeft && key <= ImGuiKey_MouseWheelY) return false;
+    if (key >= ImGuiKey_ReservedForModCtrl && key <= ImGuiKey_ReservedForModSuper) return false;
+    return true;
+}
+
+bool InputTrace::StartRecording(const char* file) {
+    Close();
+    m_out.open(file);
+    if (!m_out.is_open()) return false;
+    m_out << kHeader << "\n" << std::setprecision(9);
+    m_keyDown.assign(ImGuiKey_NamedKey_COUNT, false);
+    m_recording = true;
+    return true;
+}
+
+bool InputTrace::LoadReplay(const char* file) {
+    Close();
+    std::ifstream in(file);
+    std::string line;
+    if (!in.is_open() || !std::getline(in, line) || line != kHeader) return false;
+
+    auto coord = [](std::istringstream& iss, float& v) {
+        std::string s;
+        iss >> s;
+        v = (s == "none") ? -FLT_MAX : std::strtof(s.c_str(), nullptr);
+    };
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        std::string tag;
+        if (!(iss >> tag)) continue;
+        if (tag == "f") {
+            Frame f;
+            iss >> f.dt >> f.size.x >> f.size.y >> f.fbScale.x >> f.fbScale.y;
+            coord(iss, f.mouse.x);
+            coord(iss, f.mouse.y);
+            iss >> f.buttons >> f.wheelX >> f.wheelY >> f.mods;
+            if (!iss) return false;
+            m_frames.push_back(std::move(f));
+        }
+        else if (tag == "k" && !m_frames.empty()) {
+            KeyEvent k;
+            int down = 0;
+            if (iss >> k.name >> down) {
+                k.down = down != 0;
+                m_frames.back().keys.push_back(std::move(k));
+            }
+        }
+        else if (tag == "c" && !m_frames.empty()) {
+            unsigned c = 0;
+            if (iss >> c) m_frames.back().chars.push_back(c);
+        }
+    }
+    m_next = 0;
+    m_last = Frame();
+    m_resolved = false;
+    m_replaying = !m_frames.empty();
+    return m_replaying;
+}
+
+void InputTrace::Close() {
+    if (m_out.is_open()) m_out.close();
+    m_recording = m_replaying = false;
+    m_frames.clear();
+    m_next = 0;
+}
+
+ImVec2 InputTrace::InitialSize() const {
+    return m_frames.empty() ? ImVec2(1280, 720) : m_frames.front().size;
+}
+
+ImVec2 InputTrace::InitialFramebufferSize() const {
+    if (m_frames.empty()) return InitialSize();
+    const Frame& f = m_frames.front();
+    return ImVec2(f.size.x * f.fbScale.x, f.size.y * f.fbScale.y);
+}
+
+void InputTrace::BeforeNewFrame() {
+    if (!m_replaying || Done()) return;
+    if (!m_resolved) {
+        std::unordered_map<std::string, ImGuiKey> keys;
+        for (int k = ImGuiKey_NamedKey_BEGIN; k < ImGuiKey_NamedKey_END; ++k)
+            keys[ImGui::GetKeyName((ImGuiKey)k)] = (ImGuiKey)k;
+        for (Frame& f : m_frames)
+            for (KeyEvent& k : f.keys) {
+                auto it = keys.find(k.name);
+                k.key = (it != keys.end()) ? it->second : ImGuiKey_None;
+            }
+        m_resolved = true;
+    }
+    const Frame& f = m_frames[m_next++];
+    ImGuiIO& io = ImGui::GetIO();
+
+    // drop whatever the hidden window produced; the trace is the only input
+    io.ClearEventsQueue();
+    // the recorded states were already split across frames, apply each in one go
+    io.ConfigInputTrickleEventQueue = false;
+    io.DeltaTime = (f.dt > 0.0f) ? f.dt : kReplayDt;
+    io.DisplaySize = f.size;
+    io.DisplayFramebufferScale = f.fbScale;
+
+    io.AddMousePosEvent(f.mouse.x, f.mouse.y);
+    for (int b = 0; b < 5; ++b)
+        if (((f.buttons ^ m_last.buttons) >> b) & 1) io.AddMouseButtonEvent(b, ((f.buttons >> b) & 1) != 0);
+    if (f.wheelX != 0.0f || f.wheelY != 0.0f) io.AddMouseWheelEvent(f.wheelX, f.wheelY);
+    const ImGuiKey mods[4] = { ImGuiMod_Ctrl, ImGuiMod_Shift, ImGuiMod_Alt, ImGuiMod_Super };
+    for (int m = 0; m < 4; ++m)
+        if (((f.mods ^ m_last.mods) >> m) & 1) io.AddKeyEvent(mods[m], ((f.mods >> m) & 1) != 0);
+    for (const KeyEvent& k : f.keys)
+        if (k.key != ImGuiKey_None) io.AddKeyEvent(k.key, k.down);
+    for (unsigned c : f.chars) io.AddInputCharacter(c);
+    m_last = f;
+}
+
+void InputTrace::AfterNewFrame() {
+    if (!m_recording) return;
+    const ImGuiIO& io = ImGui::GetIO();
+    Frame f;
+    f.dt = io.DeltaTime;
+    f.size = io.DisplaySize;
+    f.fbScale = io.DisplayFramebufferScale;
+    f.mouse = io.MousePos;
+    for (int b = 0; b < 5; ++b)
+        if (io.MouseDown[b]) f.buttons |= 1 << b;
+    f.wheelX = io.MouseWheelH;
+    f.wheelY = io.MouseWheel;
+    f.mods = (io.KeyCtrl ? 1 : 0) | (io.KeyShift ? 2 : 0) | (io.KeyAlt ? 4 : 0) | (io.KeySuper ? 8 : 0);
+
+    m_out << "f " << f.dt << " " << f.size.x << " " << f.size.y << " " << f.fbScale.x << " " << f.fbScale.y;
+    if (ImGui::IsMousePosValid(&f.mouse)) m_out << " " << f.mouse.x << " " << f.mouse.y;
+    else m_out << " none none";
+    m_out << " " << f.buttons << " " << f.wheelX << " " << f.wheelY << " " << f.mods << "\n";
+
+    for (int k = ImGuiKey_NamedKey_BEGIN; k < ImGuiKey_NamedKey_END; ++k) {
+        if (!Replayable((ImGuiKey)k)) continue;
+        const bool down = ImGui::IsKeyDown((ImGuiKey)k);
+        if (down == m_keyDown[k - ImGuiKey_NamedKey_BEGIN]) continue;
+        m_keyDown[k - ImGuiKey_NamedKey_BEGIN] = down;
+        m_out << "k " << ImGui::GetKeyName((ImGuiKey)k) << " " << (down ? 1 : 0) << "\n";
+    }
+    for (ImWchar c : io.InputQueueCharacters) m_out << "c " << (unsigned)c << "\n";
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <imgui.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Input of a session, frame by frame, as ImGui saw it after NewFrame: mouse,
+// buttons, wheel, modifier and key transitions, typed characters and the
+// display size. Replay feeds each frame back through the io Add*Event API
+// with the recorded time step, so the panels, the zoom spring and every edit
+// run exactly as recorded regardless of how fast frames are produced.
+class InputTrace {
+public:
+    // Time step of replayed frames that carry none.
+    static constexpr float kReplayDt = 1.0f / 60.0f;
+
+    bool StartRecording(const char* file);
+    bool LoadReplay(const char* file);
+    void Close();
+
+    bool Recording() const { return m_recording; }
+    bool Replaying() const { return m_replaying; }
+    // Replay ran past its last frame.
+    bool Done() const { return m_replaying && m_next >= m_frames.size(); }
+    size_t FrameCount() const { return m_frames.size(); }
+    // Display size of the first recorded frame (window points / framebuffer pixels).
+    ImVec2 InitialSize() const;
+    ImVec2 InitialFramebufferSize() const;
+
+    // Around ImGui::NewFrame, after the platform backend's NewFrame: replay
+    // replaces the queued input with the next recorded frame, recording
+    // stores what NewFrame processed.
+    void BeforeNewFrame();
+    void AfterNewFrame();
+
+private:
+    struct KeyEvent {
+        std::string name;               // resolved to key on the first replayed frame
+        ImGuiKey key = ImGuiKey_None;
+        bool down = false;
+    };
+    struct Frame {
+        float dt = 0.0f;                // as recorded; 0 when the trace has none
+        ImVec2 size, fbScale;
+        ImVec2 mouse;                   // -FLT_MAX when the mouse is outside
+        int buttons = 0;                // bit per ImGuiMouseButton
+        float wheelX = 0.0f, wheelY = 0.0f;
+        int mods = 0;                   // bit 0 ctrl, 1 shift, 2 alt, 3 super
+        std::vector<KeyEvent> keys;
+        std::vector<unsigned> chars;
+    };
+
+    bool m_recording = false;
+    bool m_replaying = false;
+    std::ofstream m_out;
+    std::vector<bool> m_keyDown;        // recorder's view of every named key
+    Frame m_last;                       // previous frame replayed
+
+    std::vector<Frame> m_frames;
+    size_t m_next = 0;
+    bool m_resolved = false;            // key names mapped (needs an ImGui context)
+};
@@ -0,0 +1,116 @@
+#include "SpectrumAnalyzer.h"
+#include "Fft.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <memory>
+
+SpectrumAnalyzer::SpectrumAnalyzer() {
+    m_thread = std::thread(&SpectrumAnalyzer::Loop, this);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void SpectrumAnalyzer::Submit(std::vector<double>&& samples, double dx, int window, unsigned version) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_request.samples = std::move(samples);
+        m_request.dx = dx;
+        m_request.window = window;
+        m_request.version = version;
+        m_pending = true;
+    }
+    m_wake.notify_one();
+}
+
+bool SpectrumAnalyzer::Poll(Result& out, unsigned version) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_result.size == 0 || m_result.version == version) return false;
+    out = m_result;
+    return true;
+}
+
+bool SpectrumAnalyzer::Busy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending || m_running;
+}
+
+void SpectrumAnalyzer::Loop() {
+    Request req;
+    Result res;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_running = false;
+            m_wake.wait(lock, [&] { return m_quit || m_pending; });
+            if (m_quit) return;
+            std::swap(req, m_request);
+            m_pending = false;
+            m_running = true;
+        }
+        Compute(req, res);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(m_result, res);
+    }
+}
+
+void SpectrumAnalyzer::Compute(Request& req, Result& res) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const int count = (int)std::min(req.samples.size(), (size_t)kMaxSize);
+    res = Result();
+    res.version = req.version;
+    res.samples = count;
+    if (count < 2) return;
+
+    // zero-pad to the next power of two; the plan is kept while the size holds
+    int n = 2;
+    while (n < count) n <<= 1;
+    static thread_local std::unique_ptr<RealFft> fft;
+    if (!fft || fft->Size() != n) fft = std::make_unique<RealFft>(n);
+
+    const double pi = 3.14159265358979323846;
+    std::vector<double>& x = req.samples;
+    x.resize(n, 0.0);
+    double gain = 0.0;
+    for (int i = 0; i < count; ++i) {
+        const double t = count > 1 ? (double)i / (count - 1) : 0.0;
+        double w = 1.0;
+        switch (req.window) {
+        case WINDOW_HANN:     w = 0.5 - 0.5 * std::cos(2.0 * pi * t); break;
+        case WINDOW_HAMMING:  w = 0.54 - 0.46 * std::cos(2.0 * pi * t); break;
+        case WINDOW_BLACKMAN: w = 0.42 - 0.5 * std::cos(2.0 * pi * t) + 0.08 * std::cos(4.0 * pi * t); break;
+        default: break;
+        }
+        if (!std::isfinite(x[i])) {
+            x[i] = 0.0;
+            ++res.nonFinite;
+        }
+        x[i] *= w;
+        gain += w;
+    }
+
+    std::vector<std::complex<double>> bins;
+    fft->Forward(x, bins);
+
+    // single-sided amplitude: a sine of amplitude A reads A at its bin
+    const int nb = n / 2 + 1;
+    res.magnitude.resize(nb);
+    res.phase.resize(nb);
+    const double norm = gain > 0.0 ? 1.0 / gain : 0.0;
+    for (int k = 0; k < nb; ++k) {
+        const double scale = (k == 0 || k == n / 2) ? norm : 2.0 * norm;
+        res.magnitude[k] = (float)(std::abs(bins[k]) * scale);
+        res.phase[k] = (float)std::arg(bins[k]);
+    }
+    res.size = n;
+    res.binWidth = 1.0 / (n * req.dx);
+    res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum SpectrumWindow {
+    WINDOW_RECT = 0,
+    WINDOW_HANN,
+    WINDOW_HAMMING,
+    WINDOW_BLACKMAN
+};
+
+// Spectra of uniformly spaced samples, computed on a dedicated thread so
+// transforms of up to 2^20 points never stall a frame. Submitting replaces
+// any request that has not started yet; the newest finished result is kept.
+class SpectrumAnalyzer {
+public:
+    static constexpr int kMaxSize = 1 << 20;
+
+    struct Result {
+        std::vector<float> magnitude;   // amplitude per bin, window gain removed
+        std::vector<float> phase;       // radians
+        double binWidth = 0.0;          // cycles per x unit between bins
+        int samples = 0;                // input samples (the rest is zero padding)
+        int size = 0;                   // transform size
+        int nonFinite = 0;              // samples replaced by zero
+        double ms = 0.0;                // time spent on the worker
+        unsigned version = 0;           // of the submitted samples
+    };
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer();
+
+    // Takes the samples by move; dx is their spacing in x.
+    void Submit(std::vector<double>&& samples, double dx, int window, unsigned version);
+    // Copies the newest result if it is newer than `version`.
+    bool Poll(Result& out, unsigned version) const;
+    bool Busy() const;
+
+private:
+    struct Request {
+        std::vector<double> samples;
+        double dx = 1.0;
+        int window = WINDOW_HANN;
+        unsigned version = 0;
+    };
+
+    void Loop();
+    static void Compute(Request& req, Result& res);
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_quit = false;
+    bool m_pending = false;
+    bool m_running = false;
+    Request m_request;
+    Result m_result;
+};
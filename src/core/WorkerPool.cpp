@@ -0,0 +1,77 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+WorkerPool& WorkerPool::Instance() {
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::WorkerPool() {
+    unsigned n = std::thread::hardware_concurrency();
+    if (n == 0) n = 4;
+    for (unsigned i = 1; i < n; ++i)
+        m_threads.emplace_back(&WorkerPool::WorkerLoop, this, i);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_threads) t.join();
+}
+
+void WorkerPool::RunChunks(unsigned worker) {
+    for (;;) {
+        const int begin = m_next.fetch_add(m_chunk);
+        if (begin >= m_count) break;
+        (*m_fn)(begin, std::min(begin + m_chunk, m_count), worker);
+    }
+}
+
+void WorkerPool::WorkerLoop(unsigned worker) {
+    unsigned seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_quit || m_jobId != seen; });
+            if (m_quit) return;
+            seen = m_jobId;
+        }
+        RunChunks(worker);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0) m_done.notify_one();
+        }
+    }
+}
+
+void WorkerPool::ParallelFor(int count, int grain, const RangeFn& fn) {
+    if (count <= 0) return;
+    grain = std::max(grain, 1);
+    if (m_threads.empty() || count <= grain) {
+        fn(0, count, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> forLock(m_forMutex);
+    // a few chunks per thread balances uneven expression cost
+    const int chunks = (int)Size() * 4;
+    m_chunk = std::max(grain, (count + chunks - 1) / chunks);
+    m_count = count;
+    m_fn = &fn;
+    m_next.store(0);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy = (unsigned)m_threads.size();
+        ++m_jobId;
+    }
+    m_wake.notify_all();
+
+    RunChunks(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_busy == 0; });
+    m_fn = nullptr;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Process-wide pool of sampling threads. The calling thread takes part in
+// every ParallelFor as worker 0, so per-worker state can be sized by Size().
+// ParallelFor calls are serialized and must not be nested.
+class WorkerPool {
+public:
+    using RangeFn = std::function<void(int begin, int end, unsigned worker)>;
+
+    static WorkerPool& Instance();
+
+    unsigned Size() const { return (unsigned)m_threads.size() + 1; }
+
+    // Runs fn over [0, count) in chunks of at least `grain` items and blocks
+    // until all chunks are done. Small ranges run inline on the caller.
+    void ParallelFor(int count, int grain, const RangeFn& fn);
+
+private:
+    WorkerPool();
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void WorkerLoop(unsigned worker);
+    void RunChunks(unsigned worker);
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_forMutex;          // one ParallelFor at a time
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    unsigned m_jobId = 0;
+    unsigned m_busy = 0;            // workers still inside the current job
+    bool m_quit = false;
+
+    const RangeFn* m_fn = nullptr;
+    int m_count = 0;
+    int m_chunk = 1;
+    std::atomic<int> m_next{ 0 };
+};
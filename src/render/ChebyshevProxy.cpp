@@ -0,0 +1,426 @@
+#include "ChebyshevProxy.h"
+#include "Evaluator.h"
+#include "core/Config.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+// SSE2 is part of x86-64 and NEON of AArch64, so neither needs a build flag.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHEB_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CHEB_NEON 1
+#endif
+
+static constexpr int    kStartHalf = 8;             // a new piece is sampled at 2 * 8 + 1 points
+static constexpr int    kMaxDegree = 128;
+static constexpr int    kMaxDepth = 20;             // pieces stop halving at 2^-20 of their tile
+static constexpr double kZoomHeadroom = 16.0;       // tiles are fitted this much tighter than the view needs
+static constexpr int    kMaxAncestor = 6;           // coarsest tile level searched for a view
+static constexpr size_t kMaxTiles = 64;
+static constexpr double kMaxIndex = 4.0e15;         // tile indices stay exact in double
+static constexpr double kRoundoff = 1.0e-13;        // relative accuracy a fit can reach in double
+static constexpr int    kRun = 64;                  // samples handed to Clenshaw at once
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+struct Piece {
+    double a = 0.0, b = 0.0;
+    double err = kInf;          // estimated max |p - f|, world units
+    std::vector<double> c;      // Chebyshev coefficients on [a, b]; empty when direct
+};
+
+// A piece still being fitted, holding f at the 2m + 1 points cos(pi j / 2m)
+// mapped onto [a, b] (empty until first sampled).
+struct Pending {
+    double a = 0.0, b = 0.0;
+    int depth = 0;
+    int m = kStartHalf;
+    double prevErr = kInf;
+    std::vector<double> f;
+};
+
+struct Tile {
+    double tol = 0.0;           // absolute tolerance the pieces were fitted to
+    std::vector<Piece> pieces;  // sorted by a once complete
+    std::vector<Pending> pending;
+    unsigned lastUse = 0;
+    bool Complete() const { return pending.empty() && !pieces.empty(); }
+};
+
+// Tile (L, k) covers world [k, k + 1) * 2^L.
+using TileKey = std::pair<int, int64_t>;
+
+inline int64_t FloorShift(int64_t v, int d) {
+    return v >= 0 ? (v >> d) : -((-v - 1) >> d) - 1;
+}
+
+#if defined(CHEB_SSE2)
+using V2 = __m128d;
+inline V2 Load(const double* p) { return _mm_loadu_pd(p); }
+inline void Store(double* p, V2 v) { _mm_storeu_pd(p, v); }
+inline V2 Splat(double v) { return _mm_set1_pd(v); }
+inline V2 Add(V2 a, V2 b) { return _mm_add_pd(a, b); }
+inline V2 Sub(V2 a, V2 b) { return _mm_sub_pd(a, b); }
+inline V2 Mul(V2 a, V2 b) { return _mm_mul_pd(a, b); }
+#elif defined(CHEB_NEON)
+using V2 = float64x2_t;
+inline V2 Load(const double* p) { return vld1q_f64(p); }
+inline void Store(double* p, V2 v) { vst1q_f64(p, v); }
+inline V2 Splat(double v) { return vdupq_n_f64(v); }
+inline V2 Add(V2 a, V2 b) { return vaddq_f64(a, b); }
+inline V2 Sub(V2 a, V2 b) { return vsubq_f64(a, b); }
+inline V2 Mul(V2 a, V2 b) { return vmulq_f64(a, b); }
+#endif
+
+// sum c[k] T_k(t[i]) for n points by the Clenshaw recurrence. With SIMD,
+// four points run as two independent vector chains to hide the latency.
+void Clenshaw(const double* c, int degree, const double* t, double* out, int n) {
+    int i = 0;
+#if defined(CHEB_SSE2) || defined(CHEB_NEON)
+    for (; i + 4 <= n; i += 4) {
+        const V2 t0 = Load(t + i), t1 = Load(t + i + 2);
+        const V2 u0 = Add(t0, t0), u1 = Add(t1, t1);
+        V2 b10 = Splat(0.0), b20 = Splat(0.0);
+        V2 b11 = Splat(0.0), b21 = Splat(0.0);
+        for (int k = degree; k >= 1; --k) {
+            const V2 ck = Splat(c[k]);
+            const V2 n0 = Sub(Add(ck, Mul(u0, b10)), b20);
+            const V2 n1 = Sub(Add(ck, Mul(u1, b11)), b21);
+            b20 = b10; b10 = n0;
+            b21 = b11; b11 = n1;
+        }
+        const V2 c0 = Splat(c[0]);
+        Store(out + i, Sub(Add(c0, Mul(t0, b10)), b20));
+        Store(out + i + 2, Sub(Add(c0, Mul(t1, b11)), b21));
+    }
+#endif
+    for (; i < n; ++i) {
+        const double u = 2.0 * t[i];
+        double b1 = 0.0, b2 = 0.0;
+        for (int k = degree; k >= 1; --k) {
+            const double b0 = c[k] + u * b1 - b2;
+            b2 = b1;
+            b1 = b0;
+        }
+        out[i] = c[0] + t[i] * b1 - b2;
+    }
+}
+
+// Coefficients of the degree-n interpolant through f[j * stride] at the
+// points cos(pi j / n), j = 0..n: a type-I DCT, done directly as n <= 128.
+void Coefficients(const double* f, int stride, int n, std::vector<double>& c) {
+    std::vector<double> cosine(2 * n);
+    for (int j = 0; j < 2 * n; ++j) cosine[j] = std::cos(kPi * j / n);
+    c.assign(n + 1, 0.0);
+    for (int k = 0; k <= n; ++k) {
+        const double last = f[n * stride];
+        double s = 0.5 * (f[0] + ((k & 1) ? -last : last));
+        for (int j = 1; j < n; ++j) s += f[j * stride] * cosine[(j * k) % (2 * n)];
+        c[k] = s * (2.0 / n);
+    }
+    c[0] *= 0.5;
+    c[n] *= 0.5;
+}
+
+} // namespace
+
+struct ChebyshevProxy::Impl {
+    std::map<TileKey, Tile> tiles;
+    unsigned generation = ~0u;
+    unsigned frame = 0;
+    double nsPerEval = 500.0;           // cost of the expression while fitting
+
+    std::vector<const Piece*> active;   // pieces serving the view, sorted by a
+    double tolWorld = 0.0;
+    size_t samples = 0, directSamples = 0;
+    Stats stats;
+
+    // Finest fitted tile at level L or coarser that covers tile (L, k) and
+    // was fitted tightly enough for the current zoom.
+    Tile* Serving(int L, int64_t k) {
+        for (int d = 0; d <= kMaxAncestor; ++d) {
+            auto it = tiles.find({ L + d, FloorShift(k, d) });
+            if (it == tiles.end() || !it->second.Complete() || it->second.tol > tolWorld) continue;
+            it->second.lastUse = frame;
+            return &it->second;
+        }
+        return nullptr;
+    }
+
+    // Splits a piece that did not converge, or hands it to direct
+    // evaluation once it is as narrow as pieces get.
+    static void Split(Tile& tile, const Pending& q, std::vector<Pending>& next) {
+        if (q.depth >= kMaxDepth) {
+            tile.pieces.push_back({ q.a, q.b, kInf, {} });
+            return;
+        }
+        const double mid = 0.5 * (q.a + q.b);
+        Pending lo, hi;
+        lo.a = q.a; lo.b = mid; lo.depth = q.depth + 1;
+        hi.a = mid; hi.b = q.b; hi.depth = q.depth + 1;
+        next.push_back(std::move(lo));
+        next.push_back(std::move(hi));
+    }
+
+    // Checks the degree-m interpolant through the even points of q against
+    // the odd ones: accepts the degree-2m fit when it is within tolerance,
+    // asks for the next level while the error keeps dropping, splits otherwise.
+    static void Test(Tile& tile, Pending& q, std::vector<Pending>& next) {
+        const int m = q.m;
+        int finite = 0;
+        double scale = 0.0;
+        for (double v : q.f) {
+            if (!std::isfinite(v)) continue;
+            ++finite;
+            scale = std::max(scale, std::fabs(v));
+        }
+        if (finite == 0) {
+            // undefined throughout, e.g. sqrt(x) left of 0: nothing to fit
+            tile.pieces.push_back({ q.a, q.b, kInf, {} });
+            return;
+        }
+        if (finite < (int)q.f.size()) {
+            Split(tile, q, next);
+            return;
+        }
+
+        std::vector<double> c, t(m), p(m);
+        Coefficients(q.f.data(), 2, m, c);
+        for (int j = 0; j < m; ++j) t[j] = std::cos(kPi * (2 * j + 1) / (2 * m));
+        Clenshaw(c.data(), m, t.data(), p.data(), m);
+        double err = 0.0;
+        for (int j = 0; j < m; ++j) err = std::max(err, std::fabs(p[j] - q.f[2 * j + 1]));
+
+        const double tol = std::max(tile.tol, kRoundoff * scale);
+        if (err <= tol) {
+            // the degree-2m fit through all points is at least as good as the tested one
+            Piece piece{ q.a, q.b, err, {} };
+            Coefficients(q.f.data(), 1, 2 * m, piece.c);
+            double tail = 0.0;
+            while (piece.c.size() > 1 && tail + std::fabs(piece.c.back()) <= 0.1 * tol) {
+                tail += std::fabs(piece.c.back());
+                piece.c.pop_back();
+            }
+            piece.err += tail;
+            tile.pieces.push_back(std::move(piece));
+            return;
+        }
+        // a smooth piece gains digits with every doubling; one that does not
+        // is under-resolved or near a singularity and is halved instead
+        if (4 * m <= kMaxDegree && err < 0.25 * q.prevErr) {
+            q.prevErr = err;
+            next.push_back(std::move(q));
+            return;
+        }
+        Split(tile, q, next);
+    }
+
+    // Runs fitting rounds over the tiles' pending pieces until `budget`
+    // evaluations are spent; each round samples the next level of as many
+    // pieces as fit and evaluates them in one parallel batch.
+    int Fit(ExpressionSet& set, const std::vector<Tile*>& jobs, int budget) {
+        std::vector<double> xs, ys;
+        std::vector<size_t> requested(jobs.size());
+        int evaluated = 0;
+        while (evaluated < budget) {
+            xs.clear();
+            bool full = false;
+            for (size_t j = 0; j < jobs.size(); ++j) {
+                requested[j] = 0;
+                for (const Pending& q : jobs[j]->pending) {
+                    const int need = q.f.empty() ? 2 * q.m + 1 : 2 * q.m;
+                    full = full || (!xs.empty() && evaluated + (int)xs.size() + need > budget);
+                    if (full) break;
+                    const double mid = 0.5 * (q.a + q.b), half = 0.5 * (q.b - q.a);
+                    if (q.f.empty())
+                        for (int i = 0; i <= 2 * q.m; ++i) xs.push_back(mid + half * std::cos(kPi * i / (2 * q.m)));
+                    else
+                        for (int i = 0; i < 2 * q.m; ++i) xs.push_back(mid + half * std::cos(kPi * (2 * i + 1) / (4 * q.m)));
+                    ++requested[j];
+                }
+            }
+            if (xs.empty()) break;
+
+            ys.resize(xs.size());
+            const auto t0 = std::chrono::steady_clock::now();
+            WorkerPool::Instance().ParallelFor((int)xs.size(), 16, [&](int b, int e, unsigned w) {
+                Evaluator<double>& ev = set.Acquire<double>(w);
+                for (int k = b; k < e; ++k) {
+                    if (!ev.valid) { ys[k] = std::numeric_limits<double>::quiet_NaN(); continue; }
+                    ev.vars[0] = xs[k];
+                    ys[k] = ev.Value(0);
+                }
+            });
+            NoteEvalBatch(nsPerEval, t0, (double)xs.size());
+            evaluated += (int)xs.size();
+
+            // requested pieces are a prefix of each tile's pending list
+            const double* y = ys.data();
+            for (size_t j = 0; j < jobs.size(); ++j) {
+                Tile& tile = *jobs[j];
+                std::vector<Pending> next;
+                for (size_t p = 0; p < tile.pending.size(); ++p) {
+                    Pending& q = tile.pending[p];
+                    if (p >= requested[j]) {
+                        next.push_back(std::move(q));
+                        continue;
+                    }
+                    if (q.f.empty()) {
+                        q.f.assign(y, y + 2 * q.m + 1);
+                        y += 2 * q.m + 1;
+                    }
+                    else {
+                        std::vector<double> f(4 * q.m + 1);
+                        for (int i = 0; i <= 2 * q.m; ++i) f[2 * i] = q.f[i];
+                        for (int i = 0; i < 2 * q.m; ++i) f[2 * i + 1] = y[i];
+                        y += 2 * q.m;
+                        q.f.swap(f);
+                        q.m *= 2;
+                    }
+                    Test(tile, q, next);
+                }
+                tile.pending.swap(next);
+                if (tile.pending.empty())
+                    std::sort(tile.pieces.begin(), tile.pieces.end(), [](const Piece& a, const Piece& b) { return a.a < b.a; });
+            }
+        }
+        return evaluated;
+    }
+};
+
+ChebyshevProxy::ChebyshevProxy() : impl(std::make_unique<Impl>()) {}
+ChebyshevProxy::~ChebyshevProxy() = default;
+
+bool ChebyshevProxy::Prepare(ExpressionSet& set, const Viewport& vp, const AppConfig& cfg) {
+    Impl& s = *impl;
+    Stats& st = s.stats;
+    st = Stats();
+    s.active.clear();
+    s.samples = s.directSamples = 0;
+    if (!set.Valid() || !(vp.unit > 0.0)) return false;
+    if (s.generation != set.Generation()) {
+        s.tiles.clear();
+        s.generation = set.Generation();
+    }
+    ++s.frame;
+
+    // Tiles at least as wide as the view, so it overlaps two or three.
+    const double x0 = vp.MinX(), x1 = vp.MaxX();
+    s.tolWorld = std::max(cfg.proxyTolerancePx, 1.0e-4f) / vp.unit;
+    const int L = (int)std::ceil(std::log2(std::max(x1 - x0, DBL_MIN)));
+    const double W = std::ldexp(1.0, L);
+    const double f0 = std::floor(x0 / W), f1 = std::floor(x1 / W);
+    if (!(std::max(std::fabs(f0), std::fabs(f1)) <= kMaxIndex)) return false;
+
+    std::vector<Tile*> serving, jobs;
+    for (int64_t k = (int64_t)f0; k <= (int64_t)f1; ++k) {
+        if (Tile* t = s.Serving(L, k)) {
+            if (std::find(serving.begin(), serving.end(), t) == serving.end()) serving.push_back(t);
+            continue;
+        }
+        // missing, still being fitted, or fitted for a much coarser zoom
+        Tile& t = s.tiles[{ L, k }];
+        if (t.pending.empty()) {
+            t = Tile();
+            t.tol = s.tolWorld / kZoomHeadroom;
+            Pending root;
+            root.a = k * W;
+            root.b = (k + 1) * W;
+            t.pending.push_back(std::move(root));
+        }
+        t.lastUse = s.frame;
+        jobs.push_back(&t);
+    }
+
+    const int budget = std::max(SampleBudget(cfg, s.nsPerEval) / 2, 2 * kStartHalf + 1);
+    st.evaluated = s.Fit(set, jobs, budget);
+    for (Tile* t : jobs) {
+        if (t->Complete()) serving.push_back(t);
+        else ++st.fitting;
+    }
+
+    // Drop tiles nobody used this frame once the cache is over its cap.
+    if (s.tiles.size() > kMaxTiles) {
+        for (auto it = s.tiles.begin(); it != s.tiles.end();) {
+            if (it->second.lastUse != s.frame) it = s.tiles.erase(it);
+            else ++it;
+        }
+    }
+
+    for (const Tile* t : serving)
+        for (const Piece& p : t->pieces) {
+            if (p.b < x0 || p.a > x1) continue;
+            s.active.push_back(&p);
+            ++st.pieces;
+            if (p.c.empty() || p.err > s.tolWorld) {
+                ++st.direct;
+                continue;
+            }
+            st.maxDegree = std::max(st.maxDegree, (int)p.c.size() - 1);
+            st.error = std::max(st.error, p.err);
+        }
+    std::sort(s.active.begin(), s.active.end(), [](const Piece* a, const Piece* b) { return a->a < b->a; });
+    st.tiles = (int)serving.size();
+    st.errorPx = st.error * vp.unit;
+    st.cached = s.tiles.size();
+    return true;
+}
+
+void ChebyshevProxy::Evaluate(const double* xs, double* ys, unsigned char* direct, size_t n) {
+    const std::vector<const Piece*>& active = impl->active;
+    const double tol = impl->tolWorld;
+    WorkerPool::Instance().ParallelFor((int)n, 256, [&](int b, int e, unsigned) {
+        double t[kRun];
+        int i = b;
+        while (i < e) {
+            const double x = xs[i];
+            auto it = std::upper_bound(active.begin(), active.end(), x,
+                [](double v, const Piece* p) { return v < p->a; });
+            const Piece* p = (it == active.begin()) ? nullptr : *(it - 1);
+            if (!p || !(x <= p->b) || p->c.empty() || !(p->err <= tol)) {
+                direct[i] = 1;
+                ys[i] = std::numeric_limits<double>::quiet_NaN();
+                ++i;
+                continue;
+            }
+            // the following samples that fall into the same piece
+            const double mid = 0.5 * (p->a + p->b), scale = 2.0 / (p->b - p->a);
+            int j = i;
+            while (j < e && j - i < kRun && xs[j] >= p->a && xs[j] <= p->b) {
+                t[j - i] = std::clamp((xs[j] - mid) * scale, -1.0, 1.0);
+                direct[j] = 0;
+                ++j;
+            }
+            Clenshaw(p->c.data(), (int)p->c.size() - 1, t, ys + i, j - i);
+            i = j;
+        }
+    });
+
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) count += direct[i];
+    impl->samples += n;
+    impl->directSamples += count;
+    impl->stats.directShare = impl->samples ? (double)impl->directSamples / impl->samples : 0.0;
+}
+
+void ChebyshevProxy::Reset() {
+    impl->tiles.clear();
+    impl->active.clear();
+    impl->generation = ~0u;
+}
+
+const ChebyshevProxy::Stats& ChebyshevProxy::GetStats() const {
+    return impl->stats;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include "Viewport.h"
+
+struct AppConfig;
+class ExpressionSet;
+
+// Piecewise Chebyshev interpolants of y = f(x) that stand in for the
+// expression when the explicit curve is resampled. The x axis is cut into
+// world-aligned tiles of width 2^L; each tile is split into pieces whose
+// degree doubles until the interpolant matches f at the next level's points
+// to the tolerance. Pieces that never converge (poles, jumps, NaN) are
+// halved down to a minimum width and then left to direct evaluation.
+// Tiles are fitted over several frames within the evaluation budget and
+// serve every zoom level until their error shows on screen.
+class ChebyshevProxy {
+public:
+    struct Stats {
+        int tiles = 0;          // tiles serving the view
+        int fitting = 0;        // tiles of the view still being fitted
+        int pieces = 0;         // pieces overlapping the view
+        int direct = 0;         // of those, evaluated directly
+        int maxDegree = 0;
+        double error = 0.0;     // largest error estimate of a proxied piece, world units
+        double errorPx = 0.0;   // same on screen
+        double directShare = 0.0; // fraction of this frame's samples evaluated directly
+        int evaluated = 0;      // expression evaluations spent fitting this frame
+        size_t cached = 0;
+    };
+
+    ChebyshevProxy();
+    ~ChebyshevProxy();
+
+    // Fits missing tiles over the view within half the frame budget and
+    // selects the pieces Evaluate draws from. False if the proxy cannot
+    // serve this view (invalid expression, view beyond tile addressing).
+    bool Prepare(ExpressionSet& set, const Viewport& vp, const AppConfig& cfg);
+    // ys[i] = proxy(xs[i]); direct[i] is set where the expression has to
+    // be evaluated instead (no fitted piece, singular piece, or an error
+    // estimate above the tolerance at the current zoom).
+    void Evaluate(const double* xs, double* ys, unsigned char* direct, size_t n);
+    void Reset();
+
+    const Stats& GetStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -0,0 +1,440 @@
+#include "Dashboard.h"
+#include "Evaluator.h"
+#include "Viewport.h"
+#include "core/Config.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+static constexpr float  kGap = 4.0f;                // space between panes, px
+static constexpr float  kMinPaneHeight = 80.0f;     // below this the grid scrolls instead
+static constexpr int    kFirstPass = 16;            // segments of a buffer's first pass
+static constexpr size_t kMaxExprs = 256;            // compiled expressions kept when unused
+static constexpr double kDefaultSpan = 20.0;
+
+static inline ImU32 RGBA(const ImVec4& c) {
+    return IM_COL32(int(c.x * 255), int(c.y * 255), int(c.z * 255), int(c.w * 255));
+}
+
+// Clamp before narrowing so far-off values do not turn into inf/NaN floats.
+static float ClampToScreen(double v, float lo, float hi) {
+    return (float)std::clamp(v, (double)lo - 1.0e4, (double)hi + 1.0e4);
+}
+
+// Smallest 1-2-5 step (world units) whose on-screen spacing is at least minPx.
+static double NiceStep(double unit, double minPx) {
+    const double raw = minPx / unit;
+    const double mag = std::pow(10.0, std::floor(std::log10(raw)));
+    for (double m : { 1.0, 2.0, 5.0 })
+        if (m * mag >= raw) return m * mag;
+    return 10.0 * mag;
+}
+
+// Sources that differ only in leading or trailing whitespace compile to the
+// same expression; inner whitespace is kept, as word operators need it.
+static std::string ExprKey(const char* src) {
+    const char* b = src;
+    while (std::isspace((unsigned char)*b)) ++b;
+    const char* e = b + std::strlen(b);
+    while (e > b && std::isspace((unsigned char)e[-1])) --e;
+    return std::string(b, e);
+}
+
+namespace {
+
+struct Expr {
+    ExpressionSet set{ { { "x", 0 } } };
+    unsigned lastUse = 0;
+};
+
+// One expression sampled at N points over [x0, x1], refined on a nested
+// grid: a pass at stride s has evaluated every s-th index (plus the last).
+struct Buffer {
+    Expr* expr = nullptr;
+    double x0 = 0.0, x1 = 0.0;
+    int N = 0;
+    std::vector<double> ys;
+    int stride = 0;             // completed level; 0 before the first pass
+    int cursor = 0;             // next odd multiple of stride/2 to evaluate
+    unsigned created = 0;       // frame the view was first shown
+    unsigned lastUse = 0;
+    bool urgent = false;        // shown by the pane being dragged or zoomed
+
+    bool Done() const { return stride == 1; }
+};
+
+struct BufferKey {
+    std::string expr;
+    double x0, x1;
+    int N;
+    bool operator<(const BufferKey& o) const {
+        if (expr != o.expr) return expr < o.expr;
+        if (x0 != o.x0) return x0 < o.x0;
+        if (x1 != o.x1) return x1 < o.x1;
+        return N < o.N;
+    }
+};
+
+struct PaneState {
+    Viewport vp;                // pane rect and view
+    bool visible = false;
+    Expr* expr = nullptr;
+    Buffer* buffer = nullptr;
+};
+
+struct Item {
+    Buffer* buffer;
+    int index;
+};
+
+} // namespace
+
+struct Dashboard::Impl {
+    std::unordered_map<std::string, Expr> exprs;
+    std::map<BufferKey, Buffer> buffers;
+    std::vector<PaneState> panes;
+
+    int focus = -1;                     // pane filling the whole area, -1 for the grid
+    int drag = -1;                      // pane a left drag started on
+    int active = -1;                    // pane moved by input this frame
+    float scroll = 0.0f;
+    unsigned frame = 0;
+    double nsPerEval = 200.0;           // running estimate, seeded conservatively
+    Stats stats;
+    std::string noError;
+
+    // Pane rects for the area: a grid shaped after the plot, or the focused
+    // pane alone. Views come from cfg.panes.
+    void Layout(const ImVec2& pos, const ImVec2& size, const AppConfig& cfg) {
+        const int n = (int)cfg.panes.size();
+        panes.resize(n);
+        if (focus >= n) focus = -1;
+        if (n == 0 || size.x <= 0.0f || size.y <= 0.0f) {
+            for (PaneState& p : panes) p.visible = false;
+            return;
+        }
+
+        int cols = cfg.dashboardColumns;
+        if (cols <= 0) cols = (int)std::lround(std::sqrt(n * size.x / size.y));
+        cols = std::clamp(cols, 1, n);
+        const int rows = (n + cols - 1) / cols;
+        const float cellW = size.x / cols;
+        const float cellH = std::max(size.y / rows, kMinPaneHeight);
+        scroll = std::clamp(scroll, 0.0f, std::max(rows * cellH - size.y, 0.0f));
+
+        for (int i = 0; i < n; ++i) {
+            PaneState& p = panes[i];
+            ImVec2 pp, ps;
+            if (focus >= 0) {
+                pp = pos;
+                ps = size;
+                p.visible = (i == focus);
+            }
+            else {
+                pp = ImVec2(pos.x + (i % cols) * cellW, pos.y + (i / cols) * cellH - scroll);
+                ps = ImVec2(cellW, cellH);
+                p.visible = pp.y + ps.y > pos.y && pp.y < pos.y + size.y;
+            }
+            p.vp.plotPos = ImVec2(pp.x + kGap * 0.5f, pp.y + kGap * 0.5f);
+            p.vp.plotSize = ImVec2(std::max(ps.x - kGap, 1.0f), std::max(ps.y - kGap, 1.0f));
+            const DashboardPane& src = cfg.panes[i];
+            p.vp.unit = p.vp.plotSize.x / (src.spanX > 0.0 ? src.spanX : kDefaultSpan);
+            p.vp.viewX = src.viewX;
+            p.vp.viewY = src.viewY;
+        }
+    }
+
+    int PaneAt(const ImVec2& m) const {
+        for (int i = 0; i < (int)panes.size(); ++i) {
+            const Viewport& v = panes[i].vp;
+            if (panes[i].visible && m.x >= v.plotPos.x && m.x < v.plotPos.x + v.plotSize.x &&
+                m.y >= v.plotPos.y && m.y < v.plotPos.y + v.plotSize.y)
+                return i;
+        }
+        return -1;
+    }
+
+    // Queues the first pass of a new buffer: every stride-th index and the last.
+    static void FirstPass(Buffer& b, std::vector<Item>& items) {
+        int stride = 1;
+        while ((b.N - 1) / (stride * 2) >= kFirstPass) stride *= 2;
+        for (int i = 0; i < b.N; i += stride) items.push_back({ &b, i });
+        if ((b.N - 1) % stride != 0) items.push_back({ &b, b.N - 1 });
+        b.stride = stride;
+        b.cursor = stride / 2;
+    }
+
+    // Queues up to `left` midpoints of the buffer's running level; a level
+    // whose midpoints are all queued becomes the completed one.
+    static int Refine(Buffer& b, int left, std::vector<Item>& items) {
+        int queued = 0;
+        while (b.cursor < b.N - 1 && queued < left) {
+            items.push_back({ &b, b.cursor });
+            b.cursor += b.stride;
+            ++queued;
+        }
+        if (b.cursor >= b.N - 1) {
+            b.stride /= 2;
+            b.cursor = b.stride / 2;
+        }
+        return queued;
+    }
+
+    // Evaluates all queued items in one batch across the worker pool,
+    // re-acquiring an evaluator only where the expression changes.
+    void Evaluate(std::vector<Item>& items) {
+        if (items.empty()) return;
+        std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+            return a.buffer->expr < b.buffer->expr;
+        });
+        const auto t0 = std::chrono::steady_clock::now();
+        WorkerPool::Instance().ParallelFor((int)items.size(), 32, [&](int b, int e, unsigned w) {
+            Expr* current = nullptr;
+            Evaluator<double>* ev = nullptr;
+            for (int k = b; k < e; ++k) {
+                Buffer& buf = *items[k].buffer;
+                if (buf.expr != current) {
+                    current = buf.expr;
+                    ev = &current->set.Acquire<double>(w);
+                }
+                const int i = items[k].index;
+                if (!ev->valid) { buf.ys[i] = std::numeric_limits<double>::quiet_NaN(); continue; }
+                ev->vars[0] = buf.x0 + (buf.x1 - buf.x0) * ((double)i / (buf.N - 1));
+                buf.ys[i] = ev->Value(0);
+            }
+        });
+        NoteEvalBatch(nsPerEval, t0, (double)items.size());
+    }
+
+    void DrawPane(const PaneState& p, const DashboardPane& src, bool hovered, const AppConfig& cfg) const {
+        const Viewport& vp = p.vp;
+        const ImVec2 a = vp.plotPos;
+        const ImVec2 b(a.x + vp.plotSize.x, a.y + vp.plotSize.y);
+        ImDrawList* dl = ImGui::GetBackgroundDrawList();
+        dl->PushClipRect(a, b, true);
+
+        const ImU32 colGrid = RGBA(cfg.gridColor);
+        const ImU32 colAxis = RGBA(cfg.axisColor);
+        ImVec4 text = cfg.gridColor;
+        text.w = std::min(1.0f, text.w * 3.0f);
+
+        // light grid at a readable spacing, axes where they cross the pane
+        const double step = NiceStep(vp.unit, 24.0);
+        for (double k = std::floor(vp.MinX() / step), kEnd = std::ceil(vp.MaxX() / step); k <= kEnd; k += 1.0) {
+            const float x = (float)vp.ToScreenX(k * step);
+            dl->AddLine(ImVec2(x, a.y), ImVec2(x, b.y), colGrid);
+        }
+        for (double k = std::floor(vp.MinY() / step), kEnd = std::ceil(vp.MaxY() / step); k <= kEnd; k += 1.0) {
+            const float y = (float)vp.ToScreenY(k * step);
+            dl->AddLine(ImVec2(a.x, y), ImVec2(b.x, y), colGrid);
+        }
+        const double ax = vp.ToScreenX(0.0), ay = vp.ToScreenY(0.0);
+        if (ay >= a.y && ay <= b.y) dl->AddLine(ImVec2(a.x, (float)ay), ImVec2(b.x, (float)ay), colAxis);
+        if (ax >= a.x && ax <= b.x) dl->AddLine(ImVec2((float)ax, a.y), ImVec2((float)ax, b.y), colAxis);
+
+        // the completed level, the evaluated part of the running one and both ends
+        if (const Buffer* buf = p.buffer) {
+            const int N = buf->N;
+            const double dxScreen = vp.plotSize.x / (double)(N - 1);
+            const double cy = vp.CenterY();
+            const int step = std::max(buf->stride / 2, 1);
+            std::vector<ImVec2> run;
+            auto flush = [&]() {
+                if (run.size() > 1) dl->AddPolyline(run.data(), (int)run.size(), RGBA(cfg.funcColor), ImDrawFlags_None, 1.5f);
+                run.clear();
+            };
+            for (int i = 0; i < N;) {
+                if (i == 0 || i == N - 1 || i % buf->stride == 0 || i < buf->cursor) {
+                    const double y = buf->ys[i];
+                    if (std::isfinite(y)) run.emplace_back(a.x + (float)(i * dxScreen), ClampToScreen(cy - (y - vp.viewY) * vp.unit, a.y, b.y));
+                    else flush();
+                }
+                int next = (i / step + 1) * step;
+                if (next > N - 1 && i < N - 1) next = N - 1;
+                i = (next > i) ? next : N;
+            }
+            flush();
+        }
+
+        dl->AddText(ImVec2(a.x + 4.0f, a.y + 2.0f), RGBA(text), src.expr);
+        if (p.expr && !p.expr->set.Valid())
+            dl->AddText(ImVec2(a.x + 4.0f, a.y + 18.0f), IM_COL32(220, 0, 0, 255), "parse error");
+        dl->AddRect(a, b, hovered ? RGBA(cfg.funcColor) : colGrid);
+        dl->PopClipRect();
+    }
+};
+
+Dashboard::Dashboard() : impl(std::make_unique<Impl>()) {}
+Dashboard::~Dashboard() = default;
+
+void Dashboard::HandleInput(const ImVec2& pos, const ImVec2& size, AppConfig& cfg) {
+    Impl& s = *impl;
+    s.Layout(pos, size, cfg);
+    s.active = -1;
+    ImGuiIO& io = ImGui::GetIO();
+    if (!io.MouseDown[ImGuiMouseButton_Left]) s.drag = -1;
+    const int hovered = io.WantCaptureMouse ? -1 : s.PaneAt(io.MousePos);
+
+    if (hovered >= 0 && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+        s.focus = (s.focus == hovered) ? -1 : hovered;
+        s.drag = -1;
+        return;
+    }
+    if (hovered >= 0 && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) s.drag = hovered;
+
+    if (s.drag >= 0 && (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f)) {
+        DashboardPane& p = cfg.panes[s.drag];
+        const double unit = s.panes[s.drag].vp.unit;
+        p.viewX -= io.MouseDelta.x / unit;
+        p.viewY += io.MouseDelta.y / unit;
+        s.active = s.drag;
+    }
+    if (hovered >= 0 && io.MouseWheel != 0.0f && io.KeyShift && s.focus < 0) {
+        s.scroll -= io.MouseWheel * 40.0f;
+    }
+    else if (hovered >= 0 && io.MouseWheel != 0.0f) {
+        // zoom about the mouse: the world point under it stays put
+        DashboardPane& p = cfg.panes[hovered];
+        const Viewport& vp = s.panes[hovered].vp;
+        const double mx = io.MousePos.x - vp.CenterX(), my = io.MousePos.y - vp.CenterY();
+        const double wx = p.viewX + mx / vp.unit, wy = p.viewY - my / vp.unit;
+        p.spanX = std::clamp(vp.plotSize.x / vp.unit * std::pow(1.15, -io.MouseWheel), 1.0e-12, 1.0e12);
+        const double unit = vp.plotSize.x / p.spanX;
+        p.viewX = wx - mx / unit;
+        p.viewY = wy + my / unit;
+        s.active = hovered;
+    }
+    if (hovered >= 0 && ImGui::IsKeyPressed(ImGuiKey_R) && !io.WantTextInput) {
+        DashboardPane& p = cfg.panes[hovered];
+        p.viewX = p.viewY = 0.0;
+        p.spanX = kDefaultSpan;
+        s.active = hovered;
+    }
+
+    if (s.active >= 0 && cfg.dashboardLinked) {
+        const DashboardPane src = cfg.panes[s.active];
+        for (DashboardPane& p : cfg.panes) {
+            p.viewX = src.viewX;
+            p.viewY = src.viewY;
+            p.spanX = src.spanX;
+        }
+    }
+}
+
+void Dashboard::Draw(const ImVec2& pos, const ImVec2& size, const AppConfig& cfg) {
+    Impl& s = *impl;
+    ++s.frame;
+    s.Layout(pos, size, cfg);
+    Stats& st = s.stats;
+    st = Stats();
+    st.panes = (int)cfg.panes.size();
+
+    // 1. Expressions and sample buffers of the visible panes, shared by key.
+    std::vector<Buffer*> pending;
+    for (int i = 0; i < (int)s.panes.size(); ++i) {
+        PaneState& p = s.panes[i];
+        const std::string key = ExprKey(cfg.panes[i].expr);
+        auto [it, added] = s.exprs.try_emplace(key);
+        if (added) it->second.set.SetSources({ key });
+        p.expr = &it->second;
+        p.expr->lastUse = s.frame;
+        p.buffer = nullptr;
+        if (!p.visible) continue;
+        ++st.visible;
+        if (!p.expr->set.Valid()) continue;
+
+        // one sample per pixel column; the range comes from the pane's view
+        // alone, not its screen position, so equal views share a buffer
+        const int N = std::max((int)p.vp.plotSize.x + 1, 2);
+        const double halfSpan = 0.5 * p.vp.plotSize.x / p.vp.unit;
+        const double x0 = p.vp.viewX - halfSpan, x1 = p.vp.viewX + halfSpan;
+        Buffer& b = s.buffers[{ key, x0, x1, N }];
+        if (b.N == 0) {
+            b.expr = p.expr;
+            b.x0 = x0;
+            b.x1 = x1;
+            b.N = N;
+            b.ys.assign(N, std::numeric_limits<double>::quiet_NaN());
+            b.created = s.frame;
+        }
+        if (b.lastUse != s.frame) {
+            b.lastUse = s.frame;
+            b.urgent = false;
+            if (!b.Done()) pending.push_back(&b);
+        }
+        b.urgent = b.urgent || i == s.active || i == s.drag;
+        p.buffer = &b;
+    }
+
+    // 2. Schedule: first passes always, then the pane under interaction,
+    // then level by level over the rest, coarsest and longest waiting first.
+    const int budget = SampleBudget(cfg, s.nsPerEval);
+    std::vector<Item> items;
+    for (Buffer* b : pending)
+        if (b->stride == 0) Impl::FirstPass(*b, items);
+    int left = budget - (int)items.size();
+    for (Buffer* b : pending)
+        while (b->urgent && !b->Done() && left > 0) left -= Impl::Refine(*b, left, items);
+    while (left > 0) {
+        std::sort(pending.begin(), pending.end(), [](const Buffer* a, const Buffer* b) {
+            if (a->stride != b->stride) return a->stride > b->stride;
+            return a->created < b->created;
+        });
+        pending.erase(std::remove_if(pending.begin(), pending.end(), [](const Buffer* b) { return b->Done(); }), pending.end());
+        if (pending.empty()) break;
+        // every buffer at the coarsest stride finishes that level before any goes finer
+        const int coarsest = pending.front()->stride;
+        for (Buffer* b : pending) {
+            if (b->stride != coarsest || left <= 0) break;
+            left -= Impl::Refine(*b, left, items);
+        }
+    }
+    s.Evaluate(items);
+    st.evaluated = (int)items.size();
+    st.budget = budget;
+    st.nsPerEval = s.nsPerEval;
+
+    // 3. Views nobody shows any more are dropped; expressions once over the cap.
+    for (auto it = s.buffers.begin(); it != s.buffers.end();) {
+        if (it->second.lastUse != s.frame) it = s.buffers.erase(it);
+        else ++it;
+    }
+    if (s.exprs.size() > kMaxExprs) {
+        for (auto it = s.exprs.begin(); it != s.exprs.end();) {
+            if (it->second.lastUse != s.frame) it = s.exprs.erase(it);
+            else ++it;
+        }
+    }
+    st.expressions = (int)s.exprs.size();
+    st.buffers = (int)s.buffers.size();
+
+    // 4. Panes
+    const int hovered = ImGui::GetIO().WantCaptureMouse ? -1 : s.PaneAt(ImGui::GetIO().MousePos);
+    for (int i = 0; i < (int)s.panes.size(); ++i) {
+        const PaneState& p = s.panes[i];
+        if (!p.visible) continue;
+        if (p.buffer && !p.buffer->Done()) ++st.dirty;
+        s.DrawPane(p, cfg.panes[i], i == hovered, cfg);
+    }
+}
+
+bool Dashboard::HasError(int pane) const {
+    if (pane < 0 || pane >= (int)impl->panes.size() || !impl->panes[pane].expr) return false;
+    return !impl->panes[pane].expr->set.Valid();
+}
+
+const std::string& Dashboard::GetLastError(int pane) const {
+    if (!HasError(pane)) return impl->noError;
+    return impl->panes[pane].expr->set.LastError();
+}
+
+const Dashboard::Stats& Dashboard::GetStats() const {
+    return impl->stats;
+}
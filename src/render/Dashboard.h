@@ -0,0 +1,47 @@
+#pragma once
+#include <imgui.h>
+#include <string>
+#include <memory>
+
+struct AppConfig;
+
+// Grid of small y = f(x) plots (cfg.panes), each with a view of its own.
+// One scheduler samples every pane: panes share a compiled expression when
+// their sources match and a sample buffer when they also show the same x
+// range, so duplicated or linked panes cost nothing extra. Each frame the
+// visible buffers get a coarse first pass, the pane being dragged or zoomed
+// is refined next, and the rest of the budget refines the others level by
+// level, coarsest first, in one parallel batch across the worker pool.
+// Hidden panes (scrolled out, or behind a focused pane) get no work.
+class Dashboard {
+public:
+    struct Stats {
+        int panes = 0;
+        int visible = 0;
+        int dirty = 0;          // visible panes not yet at full resolution
+        int expressions = 0;    // distinct compiled expressions
+        int buffers = 0;        // distinct sample buffers of the visible panes
+        int evaluated = 0;      // expression evaluations this frame
+        int budget = 0;
+        double nsPerEval = 0.0;
+    };
+
+    Dashboard();
+    ~Dashboard();
+
+    // Pan (drag), zoom (wheel) and reset (R) of the pane under the mouse, or
+    // of all panes when cfg.dashboardLinked; double-click focuses a pane and
+    // Shift+wheel scrolls a grid taller than the plot area.
+    void HandleInput(const ImVec2& pos, const ImVec2& size, AppConfig& cfg);
+    // Runs this frame's share of evaluations and draws the visible panes.
+    void Draw(const ImVec2& pos, const ImVec2& size, const AppConfig& cfg);
+
+    // Errors of a pane's expression as of the last Draw.
+    bool HasError(int pane) const;
+    const std::string& GetLastError(int pane) const;
+    const Stats& GetStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include <exprtk.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "core/Config.h"
+#include "core/FrameProfile.h"
+#include "core/WorkerPool.h"
+#include "Viewport.h"
+
+// Variable name and the slot of Evaluator::vars it is bound to. Two names
+// may share a slot (t and theta for polar curves).
+using VarBinding = std::pair<const char*, int>;
+
+// A set of expressions compiled against one symbol table, so every
+// expression of the set is evaluated from a single assignment of the
+// variables (x(t) and y(t) of a parametric curve share one t).
+template <typename T>
+struct Evaluator {
+    static constexpr int kMaxVars = 2;
+
+    exprtk::symbol_table<T> symbols;
+    std::vector<exprtk::expression<T>> exprs;
+    exprtk::parser<T> parser;
+    T vars[kMaxVars] = {};
+    unsigned generation = ~0u;
+    bool valid = false;
+    std::string lastError;
+
+    explicit Evaluator(const std::vector<VarBinding>& bindings) {
+        for (const auto& b : bindings) symbols.add_variable(b.first, vars[b.second]);
+        symbols.add_constants();
+    }
+
+    void Compile(const std::vector<std::string>& sources, unsigned gen) {
+        if (generation == gen) return;
+        generation = gen;
+        valid = !sources.empty();
+        lastError.clear();
+        exprs.assign(sources.size(), exprtk::expression<T>());
+        for (std::size_t k = 0; k < sources.size(); ++k) {
+            exprs[k].register_symbol_table(symbols);
+            if (parser.compile(sources[k], exprs[k])) continue;
+            valid = false;
+            std::ostringstream oss;
+            oss << "Parse error in expression: " << sources[k] << "\n";
+            for (std::size_t i = 0; i < parser.error_count(); ++i) {
+                auto e = parser.get_error(i);
+                oss << "Error " << i
+                    << " at pos " << e.token.position
+                    << " [" << exprtk::parser_error::to_str(e.mode)
+                    << "] " << e.diagnostic << "\n";
+            }
+            lastError += oss.str();
+        }
+    }
+
+    T Value(std::size_t k) { return exprs[k].value(); }
+};
+
+// exprtk expressions are not thread-safe: every worker of the WorkerPool gets
+// its own lazily compiled copy of the set, in each floating-point type.
+class ExpressionSet {
+public:
+    explicit ExpressionSet(std::vector<VarBinding> bindings)
+        : m_bindings(std::move(bindings)) {
+        const unsigned n = WorkerPool::Instance().Size();
+        m_f.resize(n);
+        m_d.resize(n);
+        m_l.resize(n);
+    }
+
+    // Recompiles on the calling thread (worker 0) to report errors up front.
+    bool SetSources(std::vector<std::string> sources) {
+        m_sources = std::move(sources);
+        ++m_generation;
+        Evaluator<float>& ev = Acquire<float>(0);
+        m_valid = ev.valid;
+        m_lastError = ev.lastError;
+        return m_valid;
+    }
+
+    template <typename T>
+    Evaluator<T>& Acquire(unsigned worker) {
+        auto& slots = Slots<T>();
+        if (!slots[worker]) slots[worker] = std::make_unique<Evaluator<T>>(m_bindings);
+        slots[worker]->Compile(m_sources, m_generation);
+        return *slots[worker];
+    }
+
+    bool Valid() const { return m_valid; }
+    unsigned Generation() const { return m_generation; }
+    const std::string& LastError() const { return m_lastError; }
+    const std::vector<std::string>& Sources() const { return m_sources; }
+
+private:
+    template <typename T>
+    std::vector<std::unique_ptr<Evaluator<T>>>& Slots() {
+        if constexpr (std::is_same_v<T, float>) return m_f;
+        else if constexpr (std::is_same_v<T, double>) return m_d;
+        else return m_l;
+    }
+
+    std::vector<VarBinding> m_bindings;
+    std::vector<std::string> m_sources;
+    unsigned m_generation = 0;
+    bool m_valid = false;
+    std::string m_lastError;
+    std::vector<std::unique_ptr<Evaluator<float>>>       m_f;
+    std::vector<std::unique_ptr<Evaluator<double>>>      m_d;
+    std::vector<std::unique_ptr<Evaluator<long double>>> m_l;
+};
+
+// MSVC maps long double onto double; only offer it where it is wider.
+inline constexpr bool kHasLongDouble =
+    std::numeric_limits<long double>::digits > std::numeric_limits<double>::digits;
+
+// Cheapest type whose rounding at the view's magnitude stays well below one
+// pixel; a forced mode is honoured unless long double is not wider than double.
+inline int ResolvePrecision(const Viewport& vp, int mode) {
+    if (mode == PRECISION_LONG_DOUBLE && !kHasLongDouble) return PRECISION_DOUBLE;
+    if (mode != PRECISION_AUTO) return mode;
+
+    const double pixel = 1.0 / vp.unit;
+    const double mag = std::max({ std::fabs(vp.MinX()), std::fabs(vp.MaxX()),
+                                  std::fabs(vp.MinY()), std::fabs(vp.MaxY()), pixel });
+    if (mag * std::numeric_limits<float>::epsilon() < pixel * 0.125) return PRECISION_FLOAT;
+    if (!kHasLongDouble || mag * std::numeric_limits<double>::epsilon() < pixel * 0.125) return PRECISION_DOUBLE;
+    return PRECISION_LONG_DOUBLE;
+}
+
+inline const char* PrecisionName(int p) {
+    switch (p) {
+    case PRECISION_DOUBLE:      return "double";
+    case PRECISION_LONG_DOUBLE: return "long double";
+    default:                    return "float";
+    }
+}
+
+// Calls fn with a value of the floating-point type selected by `precision`,
+// so one generic lambda instantiates the float, double and long double paths.
+template <typename Fn>
+inline void WithPrecision(int precision, Fn&& fn) {
+    switch (precision) {
+    case PRECISION_DOUBLE:      fn(0.0); break;
+    case PRECISION_LONG_DOUBLE: fn(0.0L); break;
+    default:                    fn(0.0f); break;
+    }
+}
+
+// Cost every budget assumes during a replay, so the work done per frame
+// follows the trace alone and not the speed of the build being measured.
+constexpr double kReplayEvalCostNs = 250.0;
+
+// Samples per frame that fit the evaluation budget at the measured cost.
+inline int SampleBudget(const AppConfig& cfg, double nsPerEval) {
+    const double budgetNs = std::max(cfg.frameBudgetMs, 0.1f) * 1.0e6;
+    const double cost = cfg.replaying ? kReplayEvalCostNs : nsPerEval;
+    return (int)std::clamp(budgetNs / std::max(cost, 1.0), 64.0, 1.0e7);
+}
+
+inline double ElapsedNs(std::chrono::steady_clock::time_point t0) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+// Folds a batch of `count` evaluations that took elapsedNs into a running
+// cost estimate and the frame profile's evaluation count.
+inline void NoteEvalBatch(double& nsPerEval, double elapsedNs, double count) {
+    if (count <= 0.0) return;
+    nsPerEval = 0.8 * nsPerEval + 0.2 * (elapsedNs / count);
+    FrameProfile::AddEvaluations((long long)count);
+}
+
+inline void NoteEvalBatch(double& nsPerEval, std::chrono::steady_clock::time_point t0, double count) {
+    NoteEvalBatch(nsPerEval, ElapsedNs(t0), count);
+}
@@ -0,0 +1,429 @@
+#include "HeatmapLayer.h"
+#include "Evaluator.h"
+#include "RendererGL.h"
+#include "core/Config.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+static constexpr int    kTile = 64;                 // samples per tile edge
+static constexpr size_t kMaxTiles = 2048;           // ~32 MB of cached samples
+static constexpr int    kPreviewDrop = 2;           // previews are evaluated at least 4x coarser
+static constexpr int    kMaxAncestor = 4;           // coarsest level searched for a preview
+static constexpr int    kMaxFiner = 2;              // finest level searched when zooming out
+static constexpr double kMaxIndex = 4.0e15;         // sample indices stay exact in double
+
+// Tile (tx, ty) at level L covers world [tx, tx + 1) * 64 * 2^-L in x (same in y).
+struct TileKey {
+    int level;
+    int64_t tx, ty;
+    bool operator==(const TileKey& o) const { return level == o.level && tx == o.tx && ty == o.ty; }
+};
+
+struct TileKeyHash {
+    size_t operator()(const TileKey& k) const {
+        uint64_t h = (uint64_t)k.tx * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)k.ty + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2);
+        h ^= (uint64_t)(uint32_t)k.level + (h << 6) + (h >> 2);
+        return (size_t)h;
+    }
+};
+
+struct Tile {
+    std::vector<float> v;   // row-major, row 0 at the bottom
+    float lo = 0.0f, hi = 0.0f; // robust value range (2nd/98th percentile)
+    unsigned lastUse = 0;
+};
+
+static inline int64_t FloorShift(int64_t v, int d) {
+    return v >= 0 ? (v >> d) : -((-v - 1) >> d) - 1;
+}
+
+static inline int64_t Mod(int64_t a, int64_t m) {
+    const int64_t r = a % m;
+    return r < 0 ? r + m : r;
+}
+
+// Cached tiles a visible tile is drawn from: the tile itself, its nearest
+// ancestor, or the tiles of a finer level covering it (n x n of them, row
+// major from the bottom, null where missing).
+struct TileSource {
+    static constexpr int kMaxSide = 1 << kMaxFiner;
+    int level = 0;
+    int n = 0;                          // 0 when nothing is cached
+    int count = 0;                      // non-null tiles
+    Tile* tiles[kMaxSide * kMaxSide] = {};
+};
+
+// Piecewise-linear colormaps, expanded into a 256-entry lookup table.
+static void BuildColormap(int map, std::vector<uint32_t>& lut) {
+    struct Stop { float t; int r, g, b; };
+    static const Stop viridis[] = {
+        { 0.000f,  68,   1,  84 }, { 0.125f,  71,  44, 122 }, { 0.250f,  59,  81, 139 },
+        { 0.375f,  44, 113, 142 }, { 0.500f,  33, 144, 141 }, { 0.625f,  39, 173, 129 },
+        { 0.750f,  92, 200,  99 }, { 0.875f, 170, 220,  50 }, { 1.000f, 253, 231,  37 } };
+    static const Stop coolwarm[] = {
+        { 0.00f,  59,  76, 192 }, { 0.25f, 141, 176, 254 }, { 0.50f, 221, 221, 221 },
+        { 0.75f, 244, 154, 123 }, { 1.00f, 180,   4,  38 } };
+    static const Stop gray[] = { { 0.0f, 0, 0, 0 }, { 1.0f, 255, 255, 255 } };
+
+    const Stop* stops = viridis;
+    int count = IM_ARRAYSIZE(viridis);
+    if (map == HEATMAP_COOLWARM) { stops = coolwarm; count = IM_ARRAYSIZE(coolwarm); }
+    else if (map == HEATMAP_GRAY) { stops = gray; count = IM_ARRAYSIZE(gray); }
+
+    lut.resize(256);
+    for (int i = 0; i < 256; ++i) {
+        const float t = i / 255.0f;
+        int k = 0;
+        while (k + 2 < count && t > stops[k + 1].t) ++k;
+        const Stop& a = stops[k];
+        const Stop& b = stops[k + 1];
+        const float f = std::clamp((t - a.t) / (b.t - a.t), 0.0f, 1.0f);
+        lut[i] = IM_COL32(int(a.r + (b.r - a.r) * f), int(a.g + (b.g - a.g) * f), int(a.b + (b.b - a.b) * f), 255);
+    }
+}
+
+struct HeatmapLayer::Impl {
+    ExpressionSet set{ { { "x", 0 }, { "y", 1 } } };
+
+    std::unordered_map<TileKey, Tile, TileKeyHash> tiles;
+    unsigned cacheGeneration = ~0u;
+    int cachePrecision = -1;
+    unsigned frame = 0;
+
+    // Wrap-around texture of NX x NY tile slots; tile (tx, ty) always lands
+    // in slot (tx mod NX, (-ty - 1) mod NY), so a pan only touches new tiles.
+    struct Slot {
+        TileKey key{ 0, 0, 0 };
+        int srcLevel = 0;
+        int srcCount = 0;               // tiles it was drawn from, when finer
+        unsigned colorVersion = 0;
+        bool used = false;
+    };
+    unsigned texture = 0;
+    int NX = 0, NY = 0;
+    std::vector<Slot> slots;
+
+    std::vector<uint32_t> lut;
+    int colormap = -1;
+    unsigned colorVersion = 1;
+    float lo = 0.0f, hi = 1.0f;
+    std::vector<uint32_t> pixels;       // one tile of RGBA being uploaded
+
+    Stats stats;
+    double nsPerEval = 300.0;
+
+    // Own tile, else the nearest cached ancestor within kMaxAncestor levels,
+    // else the finer level within kMaxFiner that has most of the tile cached.
+    TileSource Source(const TileKey& key) {
+        TileSource src;
+        for (int d = 0; d <= kMaxAncestor; ++d) {
+            auto it = tiles.find({ key.level - d, FloorShift(key.tx, d), FloorShift(key.ty, d) });
+            if (it == tiles.end()) continue;
+            it->second.lastUse = frame;
+            src.level = key.level - d;
+            src.n = src.count = 1;
+            src.tiles[0] = &it->second;
+            return src;
+        }
+        for (int d = 1; d <= kMaxFiner; ++d) {
+            TileSource f;
+            f.level = key.level + d;
+            f.n = 1 << d;
+            for (int j = 0; j < f.n; ++j)
+                for (int i = 0; i < f.n; ++i) {
+                    auto it = tiles.find({ f.level, key.tx * f.n + i, key.ty * f.n + j });
+                    if (it == tiles.end()) continue;
+                    f.tiles[j * f.n + i] = &it->second;
+                    ++f.count;
+                }
+            if (f.count > 0 && (src.n == 0 || f.count * src.n * src.n > src.count * f.n * f.n)) src = f;
+        }
+        for (int k = 0; k < src.n * src.n; ++k)
+            if (src.tiles[k]) src.tiles[k]->lastUse = frame;
+        return src;
+    }
+
+    void EvaluateTiles(const std::vector<TileKey>& jobs, int precision) {
+        if (jobs.empty()) return;
+        std::vector<Tile*> dst;
+        dst.reserve(jobs.size());
+        for (const TileKey& k : jobs) {
+            Tile& t = tiles[k];
+            t.v.resize(kTile * kTile);
+            t.lastUse = frame;
+            dst.push_back(&t);
+        }
+
+        // one row of one tile per work item, rows contiguous in memory
+        WithPrecision(precision, [&](auto tag) {
+            using T = decltype(tag);
+            WorkerPool::Instance().ParallelFor((int)jobs.size() * kTile, 4, [&](int b, int e, unsigned w) {
+                Evaluator<T>& ev = set.Acquire<T>(w);
+                for (int r = b; r < e; ++r) {
+                    const TileKey& k = jobs[r / kTile];
+                    const int py = r % kTile;
+                    float* row = dst[r / kTile]->v.data() + py * kTile;
+                    if (!ev.valid) {
+                        std::fill(row, row + kTile, std::numeric_limits<float>::quiet_NaN());
+                        continue;
+                    }
+                    const T s = T(std::ldexp(1.0, -k.level));
+                    ev.vars[1] = (T(k.ty * kTile + py) + T(0.5)) * s;
+                    const T x0 = (T(k.tx * kTile) + T(0.5)) * s;
+                    for (int px = 0; px < kTile; ++px) {
+                        ev.vars[0] = x0 + T(px) * s;
+                        row[px] = (float)ev.Value(0);
+                    }
+                }
+            });
+        });
+
+        // robust per-tile range, so a pole does not wash out the colormap
+        WorkerPool::Instance().ParallelFor((int)dst.size(), 1, [&](int b, int e, unsigned) {
+            std::vector<float> finite;
+            finite.reserve(kTile * kTile);
+            for (int k = b; k < e; ++k) {
+                Tile& t = *dst[k];
+                finite.clear();
+                for (float v : t.v)
+                    if (std::isfinite(v)) finite.push_back(v);
+                if (finite.empty()) {
+                    t.lo = t.hi = std::numeric_limits<float>::quiet_NaN();
+                    continue;
+                }
+                const size_t n = finite.size();
+                std::nth_element(finite.begin(), finite.begin() + n / 50, finite.end());
+                t.lo = finite[n / 50];
+                std::nth_element(finite.begin(), finite.begin() + (n - 1 - n / 50), finite.end());
+                t.hi = finite[n - 1 - n / 50];
+            }
+        });
+    }
+
+    // Colors one tile slot from `src`, top row first: an ancestor is
+    // upsampled, a finer level picked one sample per pixel.
+    void Colorize(const TileKey& key, const TileSource& src) {
+        pixels.resize(kTile * kTile);
+        const float span = hi - lo;
+        const float scale = span > 0.0f ? 255.0f / span : 0.0f;
+        auto color = [&](float v) {
+            if (!std::isfinite(v)) return 0u;
+            return lut[(int)std::clamp((v - lo) * scale, 0.0f, 255.0f)];
+        };
+        if (src.level <= key.level) {
+            const int d = key.level - src.level;
+            const Tile& t = *src.tiles[0];
+            for (int r = 0; r < kTile; ++r) {
+                const int py = kTile - 1 - r;
+                const int64_t sy = FloorShift(key.ty * kTile + py, d) - FloorShift(key.ty, d) * kTile;
+                const float* row = t.v.data() + sy * kTile;
+                uint32_t* out = pixels.data() + r * kTile;
+                for (int px = 0; px < kTile; ++px) {
+                    const int64_t sx = FloorShift(key.tx * kTile + px, d) - FloorShift(key.tx, d) * kTile;
+                    out[px] = color(row[sx]);
+                }
+            }
+            return;
+        }
+        const int n = src.n;
+        for (int r = 0; r < kTile; ++r) {
+            const int fy = (kTile - 1 - r) * n + n / 2;     // sample row across the finer tiles
+            uint32_t* out = pixels.data() + r * kTile;
+            for (int px = 0; px < kTile; ++px) {
+                const int fx = px * n + n / 2;
+                const Tile* t = src.tiles[(fy / kTile) * n + fx / kTile];
+                out[px] = t ? color(t->v[(fy % kTile) * kTile + fx % kTile]) : 0u;
+            }
+        }
+    }
+};
+
+HeatmapLayer::HeatmapLayer() : impl(std::make_unique<Impl>()) {}
+HeatmapLayer::~HeatmapLayer() = default;
+
+void HeatmapLayer::SetExpression(const std::string& expr) {
+    impl->set.SetSources({ expr });
+}
+
+bool HeatmapLayer::HasError() const {
+    return !impl->set.Valid();
+}
+
+const std::string& HeatmapLayer::GetLastError() const {
+    return impl->set.LastError();
+}
+
+const HeatmapLayer::Stats& HeatmapLayer::GetStats() const {
+    return impl->stats;
+}
+
+void HeatmapLayer::Draw(const Viewport& vp, const AppConfig& cfg, RendererGL& renderer) {
+    if (!cfg.showHeatmap || !impl->set.Valid() || !(vp.unit > 0.0)) return;
+    ++impl->frame;
+
+    const int precision = ResolvePrecision(vp, cfg.precisionMode);
+    if (impl->cacheGeneration != impl->set.Generation() || impl->cachePrecision != precision) {
+        impl->tiles.clear();
+        impl->cacheGeneration = impl->set.Generation();
+        impl->cachePrecision = precision;
+        for (auto& s : impl->slots) s.used = false;
+    }
+
+    // Sample spacing 2^-L world units, between heatPx/2 and heatPx on screen.
+    // The texture must hold the visible tiles at the smallest tile size.
+    const int maxTex = renderer.MaxTextureSize();
+    double heatPx = std::max(cfg.heatmapPixel, 1.0f);
+    auto slotsFor = [&](float extent, double px) { return (int)std::ceil(extent / (kTile * px * 0.5)) + 1; };
+    while (std::max(slotsFor(vp.plotSize.x, heatPx), slotsFor(vp.plotSize.y, heatPx)) * kTile > maxTex)
+        heatPx *= 2.0;
+    const int L = (int)std::ceil(std::log2(vp.unit / heatPx));
+    const double tileW = kTile * std::ldexp(1.0, -L);
+
+    const double fx0 = std::floor(vp.MinX() / tileW), fx1 = std::floor(vp.MaxX() / tileW);
+    const double fy0 = std::floor(vp.MinY() / tileW), fy1 = std::floor(vp.MaxY() / tileW);
+    if (std::max({ std::fabs(fx0), std::fabs(fx1), std::fabs(fy0), std::fabs(fy1) }) * kTile > kMaxIndex)
+        return; // beyond what tile indices can address
+    const int64_t tx0 = (int64_t)fx0, tx1 = (int64_t)fx1;
+    const int64_t ty0 = (int64_t)fy0, ty1 = (int64_t)fy1;
+
+    const int NX = slotsFor(vp.plotSize.x, heatPx);
+    const int NY = slotsFor(vp.plotSize.y, heatPx);
+    if (!impl->texture || NX != impl->NX || NY != impl->NY) {
+        if (impl->texture) renderer.DestroyTexture(impl->texture);
+        impl->texture = renderer.CreateTexture(NX * kTile, NY * kTile, true);
+        impl->NX = NX;
+        impl->NY = NY;
+        impl->slots.assign((size_t)NX * NY, Impl::Slot());
+    }
+
+    Stats& st = impl->stats;
+    st = Stats();
+    st.pixelPx = vp.unit * std::ldexp(1.0, -L);
+
+    // 1. Visible tiles; missing ones are ordered from the view center out.
+    std::vector<TileKey> visible, missing, uncovered, previews;
+    const double cxTile = vp.viewX / tileW - 0.5, cyTile = vp.viewY / tileW - 0.5;
+    for (int64_t ty = ty0; ty <= ty1; ++ty) {
+        for (int64_t tx = tx0; tx <= tx1; ++tx) {
+            const TileKey key{ L, tx, ty };
+            visible.push_back(key);
+            auto it = impl->tiles.find(key);
+            if (it != impl->tiles.end()) {
+                it->second.lastUse = impl->frame;
+                continue;
+            }
+            missing.push_back(key);
+            if (impl->Source(key).n == 0) uncovered.push_back(key);
+        }
+    }
+
+    // Previews for the tiles nothing cached covers, at the finest level whose
+    // previews fit the budget (a fast zoom out needs a coarse one).
+    const int budgetTiles = std::max(1, SampleBudget(cfg, impl->nsPerEval) / (kTile * kTile));
+    int drop = kPreviewDrop;
+    for (; drop <= kMaxAncestor; ++drop) {
+        previews.clear();
+        for (const TileKey& k : uncovered) {
+            const TileKey p{ L - drop, FloorShift(k.tx, drop), FloorShift(k.ty, drop) };
+            if (std::find(previews.begin(), previews.end(), p) == previews.end()) previews.push_back(p);
+        }
+        if ((int)previews.size() <= budgetTiles || drop == kMaxAncestor) break;
+    }
+    auto byDistance = [&](double scale) {
+        return [=](const TileKey& a, const TileKey& b) {
+            const double da = std::hypot((a.tx + 0.5) * scale - 0.5 - cxTile, (a.ty + 0.5) * scale - 0.5 - cyTile);
+            const double db = std::hypot((b.tx + 0.5) * scale - 0.5 - cxTile, (b.ty + 0.5) * scale - 0.5 - cyTile);
+            return da < db;
+        };
+    };
+    std::sort(missing.begin(), missing.end(), byDistance(1.0));
+    std::sort(previews.begin(), previews.end(), byDistance(1 << drop));
+
+    // 2. Previews, then exact tiles, both nearest first and together within
+    //    the budget.
+    std::vector<TileKey> jobs;
+    for (const std::vector<TileKey>* list : { &previews, &missing })
+        for (const TileKey& k : *list) {
+            if ((int)jobs.size() >= budgetTiles) break;
+            jobs.push_back(k);
+        }
+    if (!jobs.empty()) {
+        const auto t0 = std::chrono::steady_clock::now();
+        impl->EvaluateTiles(jobs, precision);
+        NoteEvalBatch(impl->nsPerEval, t0, (double)jobs.size() * kTile * kTile);
+    }
+    st.evaluated = (int)jobs.size();
+
+    // 3. Value range and colormap; a change recolors every slot.
+    float lo = cfg.heatmapMin, hi = cfg.heatmapMax;
+    if (cfg.heatmapAutoRange) {
+        lo = std::numeric_limits<float>::infinity();
+        hi = -lo;
+        for (const TileKey& k : visible) {
+            const TileSource src = impl->Source(k);
+            for (int i = 0; i < src.n * src.n; ++i) {
+                const Tile* t = src.tiles[i];
+                if (!t) continue;
+                if (std::isfinite(t->lo)) lo = std::min(lo, t->lo);
+                if (std::isfinite(t->hi)) hi = std::max(hi, t->hi);
+            }
+        }
+        if (!(lo <= hi)) { lo = 0.0f; hi = 1.0f; }
+    }
+    if (hi <= lo) hi = lo + 1.0f;
+    const float span = std::max(impl->hi - impl->lo, 1e-30f);
+    if (impl->colormap != cfg.heatmapColormap ||
+        std::fabs(lo - impl->lo) > 0.02f * span || std::fabs(hi - impl->hi) > 0.02f * span) {
+        if (impl->colormap != cfg.heatmapColormap) BuildColormap(cfg.heatmapColormap, impl->lut);
+        impl->colormap = cfg.heatmapColormap;
+        impl->lo = lo;
+        impl->hi = hi;
+        ++impl->colorVersion;
+    }
+    st.lo = impl->lo;
+    st.hi = impl->hi;
+
+    // 4. Upload slots whose content changed.
+    for (const TileKey& k : visible) {
+        const int sx = (int)Mod(k.tx, NX), sy = (int)Mod(-k.ty - 1, NY);
+        Impl::Slot& slot = impl->slots[(size_t)sy * NX + sx];
+        const TileSource src = impl->Source(k);
+        if (src.level != L) ++st.previews;
+        if (slot.used && slot.key == k && slot.srcLevel == src.level && slot.srcCount == src.count &&
+            slot.colorVersion == impl->colorVersion && src.n)
+            continue;
+        if (src.n) impl->Colorize(k, src);
+        else impl->pixels.assign(kTile * kTile, 0u);
+        renderer.UpdateTexture(impl->texture, sx * kTile, sy * kTile, kTile, kTile, impl->pixels.data());
+        slot.key = k;
+        slot.srcLevel = src.level;
+        slot.srcCount = src.count;
+        slot.colorVersion = impl->colorVersion;
+        slot.used = true;
+    }
+    st.visible = (int)visible.size();
+
+    // Drop tiles nobody used this frame once the cache is over its cap.
+    if (impl->tiles.size() > kMaxTiles) {
+        for (auto it = impl->tiles.begin(); it != impl->tiles.end();) {
+            if (it->second.lastUse != impl->frame) it = impl->tiles.erase(it);
+            else ++it;
+        }
+    }
+    st.cached = impl->tiles.size();
+
+    // 5. One quad over the covered tiles; texture coordinates wrap around.
+    const ImVec2 uv0((float)Mod(tx0, NX) / NX, (float)Mod(-ty1 - 1, NY) / NY);
+    const ImVec2 uv1(uv0.x + (float)(tx1 - tx0 + 1) / NX, uv0.y + (float)(ty1 - ty0 + 1) / NY);
+    const ImVec2 pMin = vp.ToScreen((double)tx0 * tileW, (double)(ty1 + 1) * tileW);
+    const ImVec2 pMax = vp.ToScreen((double)(tx1 + 1) * tileW, (double)ty0 * tileW);
+    const ImVec2 plotMax(vp.plotPos.x + vp.plotSize.x, vp.plotPos.y + vp.plotSize.y);
+    renderer.DrawTexture(impl->texture, vp.plotPos, plotMax, pMin, pMax, uv0, uv1, cfg.heatmapAlpha);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <cstddef>
+#include "Viewport.h"
+
+struct AppConfig;
+class RendererGL;
+
+// Colormapped z = f(x, y) drawn behind the grid. The field is evaluated in
+// world-aligned 64x64 tiles that are cached across frames, so a pan only
+// evaluates the tiles entering the view. Tiles live in a wrap-around
+// texture drawn as one quad; missing tiles show an upsampled coarser level
+// until their own values arrive.
+class HeatmapLayer {
+public:
+    struct Stats {
+        int visible = 0;        // tiles covering the plot
+        int previews = 0;       // of those, still shown from a coarser level
+        int evaluated = 0;      // tiles computed this frame
+        size_t cached = 0;
+        double pixelPx = 0.0;   // on-screen size of one field sample
+        float lo = 0.0f, hi = 0.0f; // value range mapped onto the colormap
+    };
+
+    HeatmapLayer();
+    ~HeatmapLayer();
+
+    void SetExpression(const std::string& expr);
+    void Draw(const Viewport& vp, const AppConfig& cfg, RendererGL& renderer);
+
+    bool HasError() const;
+    const std::string& GetLastError() const;
+    const Stats& GetStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -0,0 +1,356 @@
+#include "ImplicitLayer.h"
+#include "Evaluator.h"
+#include "PointIndex.h"
+#include "core/Config.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+static inline ImU32 RGBA(const ImVec4& c) {
+    return IM_COL32(int(c.x * 255), int(c.y * 255), int(c.z * 255), int(c.w * 255));
+}
+
+static constexpr double kRootPx = 128.0;                // root cells span 128-256 px
+static constexpr int    kMinDepth = 2;                  // levels subdivided unconditionally
+static constexpr int    kLeafDepth = 6;                 // leaves span 2-4 px
+static constexpr size_t kMaxCachedVertices = 1u << 20;
+static constexpr double kMaxIndex = 4.0e15;             // cell indices stay exact in double
+
+// Quadtree vertex (i, j) at level L sits at world (i, j) * 2^-L.
+struct VertexKey {
+    int level;
+    int64_t i, j;
+    bool operator==(const VertexKey& o) const { return level == o.level && i == o.i && j == o.j; }
+};
+
+struct VertexKeyHash {
+    size_t operator()(const VertexKey& k) const {
+        uint64_t h = (uint64_t)k.i * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)k.j + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2);
+        h ^= (uint64_t)(uint32_t)k.level + (h << 6) + (h >> 2);
+        return (size_t)h;
+    }
+};
+
+// A vertex has a key at every level that contains it; use the coarsest, so
+// parent and child cells, and successive zoom levels, share corner values.
+static VertexKey Canonical(int level, int64_t i, int64_t j) {
+    if (i == 0 && j == 0) return { 0, 0, 0 };
+    while (((i | j) & 1) == 0) {
+        i /= 2;
+        j /= 2;
+        --level;
+    }
+    return { level, i, j };
+}
+
+struct Cell {
+    int64_t ix, iy;
+};
+
+struct Vertex {
+    double value;
+    unsigned lastUse;               // traversal that last touched the vertex
+};
+
+struct ImplicitLayer::Impl {
+    ExpressionSet set{ { { "x", 0 }, { "y", 1 } } };
+
+    std::unordered_map<VertexKey, Vertex, VertexKeyHash> values;
+    unsigned traversal = 0;
+    unsigned cacheGeneration = ~0u;
+    int cachePrecision = -1;
+
+    // root grid of the last traversal; its segments are redrawn while unchanged
+    struct ViewKey {
+        int level = 0;
+        int64_t x0 = 0, x1 = -1, y0 = 0, y1 = -1;
+        bool operator==(const ViewKey& o) const {
+            return level == o.level && x0 == o.x0 && x1 == o.x1 && y0 == o.y0 && y1 == o.y1;
+        }
+    } lastView;
+    std::vector<double> segs;           // world x0, y0, x1, y1 per segment
+    unsigned segsVersion = 0;           // bumped whenever segs is rebuilt
+    bool drawn = false;                 // segs were drawn by the last Draw
+
+    Stats stats;
+    double nsPerEval = 300.0;
+
+    struct Pending {
+        double* slot;
+        int level;
+        int64_t i, j;
+    };
+
+    double Value(int level, int64_t i, int64_t j) const {
+        auto it = values.find(Canonical(level, i, j));
+        return it != values.end() ? it->second.value : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // Queues the corners of `cells` that are not cached yet and marks all of
+    // them used by this traversal.
+    void Gather(int level, const std::vector<Cell>& cells, std::vector<Pending>& pending) {
+        for (const Cell& c : cells) {
+            for (int k = 0; k < 4; ++k) {
+                const int64_t i = c.ix + (k == 1 || k == 2);
+                const int64_t j = c.iy + (k >= 2);
+                auto res = values.try_emplace(Canonical(level, i, j), Vertex{ std::numeric_limits<double>::quiet_NaN(), traversal });
+                res.first->second.lastUse = traversal;
+                if (res.second) pending.push_back({ &res.first->second.value, level, i, j });
+            }
+        }
+    }
+
+    // Over the cap, drops the least recently used vertices down to 3/4 of it;
+    // those of the current traversal always stay.
+    void Evict() {
+        if (values.size() <= kMaxCachedVertices) return;
+        std::vector<unsigned> ages;
+        ages.reserve(values.size());
+        for (const auto& kv : values) ages.push_back(kv.second.lastUse);
+        const size_t drop = values.size() - kMaxCachedVertices / 4 * 3;
+        std::nth_element(ages.begin(), ages.begin() + (drop - 1), ages.end());
+        const unsigned cutoff = std::min(ages[drop - 1], traversal - 1);
+        for (auto it = values.begin(); it != values.end();) {
+            if (it->second.lastUse <= cutoff) it = values.erase(it);
+            else ++it;
+        }
+    }
+
+    void Evaluate(const std::vector<Pending>& pending, int precision) {
+        WithPrecision(precision, [&](auto tag) {
+            using T = decltype(tag);
+            WorkerPool::Instance().ParallelFor((int)pending.size(), 64, [&](int b, int e, unsigned w) {
+                Evaluator<T>& ev = set.Acquire<T>(w);
+                for (int k = b; k < e; ++k) {
+                    const Pending& p = pending[k];
+                    const T s = T(std::ldexp(1.0, -p.level));
+                    ev.vars[0] = T(p.i) * s;
+                    ev.vars[1] = T(p.j) * s;
+                    *p.slot = ev.valid ? (double)ev.Value(0) : std::numeric_limits<double>::quiet_NaN();
+                }
+            });
+        });
+    }
+
+    // Corner values in the order bottom-left, bottom-right, top-right, top-left.
+    void Corners(int level, const Cell& c, double v[4]) const {
+        v[0] = Value(level, c.ix, c.iy);
+        v[1] = Value(level, c.ix + 1, c.iy);
+        v[2] = Value(level, c.ix + 1, c.iy + 1);
+        v[3] = Value(level, c.ix, c.iy + 1);
+    }
+
+    static bool Straddles(const double v[4]) {
+        int finite = 0;
+        bool neg = false, pos = false;
+        for (int k = 0; k < 4; ++k) {
+            if (!std::isfinite(v[k])) continue;
+            ++finite;
+            (v[k] < 0.0 ? neg : pos) = true;
+        }
+        return finite >= 2 && neg && pos;
+    }
+
+    // Marching squares on one cell with linear edge interpolation; saddles
+    // are resolved with the mean of the corners.
+    void March(int level, const Cell& c, const double v[4]) {
+        const double s = std::ldexp(1.0, -level);
+        const double x0 = (double)c.ix * s, x1 = x0 + s;
+        const double y0 = (double)c.iy * s, y1 = y0 + s;
+        const double cx[4] = { x0, x1, x1, x0 };
+        const double cy[4] = { y0, y0, y1, y1 };
+
+        // crossings on edges bottom, right, top, left
+        double px[4], py[4];
+        bool hit[4] = {};
+        int hits = 0;
+        for (int e = 0; e < 4; ++e) {
+            const int a = e, b = (e + 1) & 3;
+            if (!std::isfinite(v[a]) || !std::isfinite(v[b]) || (v[a] < 0.0) == (v[b] < 0.0)) continue;
+            const double t = v[a] / (v[a] - v[b]);
+            px[e] = cx[a] + (cx[b] - cx[a]) * t;
+            py[e] = cy[a] + (cy[b] - cy[a]) * t;
+            hit[e] = true;
+            ++hits;
+        }
+
+        auto emit = [&](int a, int b) {
+            segs.insert(segs.end(), { px[a], py[a], px[b], py[b] });
+        };
+        if (hits == 2) {
+            int a = -1, b = -1;
+            for (int e = 0; e < 4; ++e) {
+                if (!hit[e]) continue;
+                (a < 0 ? a : b) = e;
+            }
+            emit(a, b);
+        }
+        else if (hits == 4) {
+            const double center = 0.25 * (v[0] + v[1] + v[2] + v[3]);
+            if ((center < 0.0) == (v[0] < 0.0)) {
+                emit(0, 1); // around bottom-right
+                emit(2, 3); // around top-left
+            }
+            else {
+                emit(0, 3); // around bottom-left
+                emit(1, 2); // around top-right
+            }
+        }
+    }
+};
+
+ImplicitLayer::ImplicitLayer() : impl(std::make_unique<Impl>()) {}
+ImplicitLayer::~ImplicitLayer() = default;
+
+void ImplicitLayer::SetExpression(const std::string& expr) {
+    impl->set.SetSources({ expr });
+}
+
+bool ImplicitLayer::HasError() const {
+    return !impl->set.Valid();
+}
+
+const std::string& ImplicitLayer::GetLastError() const {
+    return impl->set.LastError();
+}
+
+const ImplicitLayer::Stats& ImplicitLayer::GetStats() const {
+    return impl->stats;
+}
+
+void ImplicitLayer::Draw(const Viewport& vp, const AppConfig& cfg) {
+    impl->drawn = false;
+    if (!cfg.showImplicit || !impl->set.Valid() || !(vp.unit > 0.0)) return;
+
+    const int precision = ResolvePrecision(vp, cfg.precisionMode);
+    if (impl->cacheGeneration != impl->set.Generation() || impl->cachePrecision != precision) {
+        impl->values.clear();
+        impl->cacheGeneration = impl->set.Generation();
+        impl->cachePrecision = precision;
+        impl->lastView = Impl::ViewKey();
+    }
+
+    // root level: cells of 2^-L0 world units, at least kRootPx on screen
+    const int L0 = (int)std::floor(std::log2(vp.unit / kRootPx));
+    const double s0 = std::ldexp(1.0, -L0);
+    const double fx0 = std::floor(vp.MinX() / s0), fx1 = std::floor(vp.MaxX() / s0);
+    const double fy0 = std::floor(vp.MinY() / s0), fy1 = std::floor(vp.MaxY() / s0);
+    const double leafScale = std::ldexp(1.0, kLeafDepth);
+    if (std::max({ std::fabs(fx0), std::fabs(fx1), std::fabs(fy0), std::fabs(fy1) }) * leafScale > kMaxIndex)
+        return; // beyond what the quadtree indices can address
+
+    Impl::ViewKey view;
+    view.level = L0;
+    view.x0 = (int64_t)fx0; view.x1 = (int64_t)fx1;
+    view.y0 = (int64_t)fy0; view.y1 = (int64_t)fy1;
+
+    Stats& st = impl->stats;
+    if (!(view == impl->lastView) || !st.complete) {
+        impl->lastView = view;
+        impl->segs.clear();
+        ++impl->segsVersion;
+        st = Stats();
+        ++impl->traversal;
+
+        const int budget = SampleBudget(cfg, impl->nsPerEval);
+        const auto t0 = std::chrono::steady_clock::now();
+
+        std::vector<Cell> cells, next, straddling;
+        for (int64_t iy = view.y0; iy <= view.y1; ++iy)
+            for (int64_t ix = view.x0; ix <= view.x1; ++ix)
+                cells.push_back({ ix, iy });
+
+        std::vector<Impl::Pending> pending;
+        impl->Gather(L0, cells, pending);
+        impl->Evaluate(pending, precision);
+        st.evaluated += (int)pending.size();
+
+        double v[4];
+        for (int depth = 0; !cells.empty(); ++depth) {
+            const int level = L0 + depth;
+            next.clear();
+            straddling.clear();
+            st.cells += (int)cells.size();
+            for (const Cell& c : cells) {
+                impl->Corners(level, c, v);
+                const bool straddles = Impl::Straddles(v);
+                if (depth >= kMinDepth && !straddles) continue;
+                if (straddles) straddling.push_back(c);
+                if (depth == kLeafDepth) {
+                    impl->March(level, c, v);
+                    continue;
+                }
+                for (int k = 0; k < 4; ++k)
+                    next.push_back({ c.ix * 2 + (k & 1), c.iy * 2 + (k >> 1) });
+            }
+            if (next.empty()) break;
+
+            pending.clear();
+            impl->Gather(level + 1, next, pending);
+            if (depth + 1 > kMinDepth && st.evaluated + (int)pending.size() > budget) {
+                // Out of budget: spend what is left on part of the next level,
+                // contour this level coarsely and resume from the cache later.
+                const size_t room = (size_t)std::max(budget - st.evaluated, 64);
+                for (size_t k = room; k < pending.size(); ++k)
+                    impl->values.erase(Canonical(pending[k].level, pending[k].i, pending[k].j));
+                pending.resize(std::min(room, pending.size()));
+                impl->Evaluate(pending, precision);
+                st.evaluated += (int)pending.size();
+                for (const Cell& c : straddling) {
+                    impl->Corners(level, c, v);
+                    impl->March(level, c, v);
+                }
+                st.complete = false;
+                break;
+            }
+            impl->Evaluate(pending, precision);
+            st.evaluated += (int)pending.size();
+            cells.swap(next);
+        }
+
+        NoteEvalBatch(impl->nsPerEval, t0, st.evaluated);
+        st.segments = (int)(impl->segs.size() / 4);
+        impl->Evict();
+    }
+    else {
+        st.evaluated = 0;
+    }
+    st.cached = impl->values.size();
+
+    ImDrawList* dl = ImGui::GetBackgroundDrawList();
+    const ImVec2 plotMax(vp.plotPos.x + vp.plotSize.x, vp.plotPos.y + vp.plotSize.y);
+    dl->PushClipRect(vp.plotPos, plotMax, true);
+    const ImU32 col = RGBA(cfg.implicitColor);
+    const std::vector<double>& segs = impl->segs;
+    for (size_t k = 0; k + 3 < segs.size(); k += 4)
+        dl->AddLine(vp.ToScreen(segs[k], segs[k + 1]), vp.ToScreen(segs[k + 2], segs[k + 3]), col, 2.0f);
+    dl->PopClipRect();
+    impl->drawn = true;
+}
+
+void ImplicitLayer::Publish(PointIndex& index, int id, const AppConfig& cfg) const {
+    if (!impl->drawn) return;
+    // Segment endpoints come in marching order and mostly twice (shared by
+    // neighbouring cells); sorted by x they form tight runs for the index.
+    index.Publish(id, "f(x, y) = 0", RGBA(cfg.implicitColor), true, impl->segsVersion,
+        [&](std::vector<double>& xs, std::vector<double>& ys) {
+            const std::vector<double>& segs = impl->segs;
+            std::vector<std::pair<double, double>> p;
+            p.reserve(segs.size() / 2);
+            for (size_t k = 0; k + 1 < segs.size(); k += 2) p.push_back({ segs[k], segs[k + 1] });
+            std::sort(p.begin(), p.end());
+            p.erase(std::unique(p.begin(), p.end()), p.end());
+            xs.reserve(p.size());
+            ys.reserve(p.size());
+            for (const auto& q : p) {
+                xs.push_back(q.first);
+                ys.push_back(q.second);
+            }
+        });
+}
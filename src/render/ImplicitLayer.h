@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <cstddef>
+#include "Viewport.h"
+
+struct AppConfig;
+class PointIndex;
+
+// Contour f(x, y) = 0 traced with marching squares on a world-aligned
+// quadtree. Only cells whose corners change sign are subdivided, so the
+// work follows the contour length instead of the viewport area. Corner
+// values are cached by world position and survive pan and zoom.
+class ImplicitLayer {
+public:
+    struct Stats {
+        int cells = 0;          // cells visited by the last traversal
+        int evaluated = 0;      // corner values computed this frame
+        size_t cached = 0;      // corner values held in the cache
+        int segments = 0;
+        bool complete = true;   // false while deeper levels wait for budget
+    };
+
+    ImplicitLayer();
+    ~ImplicitLayer();
+
+    void SetExpression(const std::string& expr);
+    void Draw(const Viewport& vp, const AppConfig& cfg);
+    // Contour points, x-sorted, as series `id` of the readout index.
+    void Publish(PointIndex& index, int id, const AppConfig& cfg) const;
+
+    bool HasError() const;
+    const std::string& GetLastError() const;
+    const Stats& GetStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
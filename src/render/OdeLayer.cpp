@@ -0,0 +1,402 @@
+#include "OdeLayer.h"
+#include "Evaluator.h"
+#include "PointIndex.h"
+#include "core/Config.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+static inline ImU32 RGBA(const ImVec4& c) {
+    return IM_COL32(int(c.x * 255), int(c.y * 255), int(c.z * 255), int(c.w * 255));
+}
+
+static float ClampToScreen(double v, float lo, float hi) {
+    return (float)std::clamp(v, (double)lo - 1.0e4, (double)hi + 1.0e4);
+}
+
+static constexpr double kTolPx = 0.05;          // local error allowed per step, in pixels
+static constexpr double kRelTol = 1.0e-9;
+static constexpr double kMaxStepPx = 4.0;       // longest step along x, in pixels
+static constexpr double kRefineZoom = 4.0;      // re-integrate once zoomed in or out this far
+static constexpr double kMarginFrac = 0.25;     // integrate this far past the view edges
+static constexpr size_t kMaxPoints = 1u << 20;  // per branch; every other point is dropped beyond it
+static constexpr int    kEvalsPerStep = 6;      // Dormand-Prince is FSAL: 7 stages, 6 new
+
+// Dormand-Prince 5(4) tableau; b is the 5th-order row (a7*), e = b - b*.
+static const double kC[7] = { 0.0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1.0, 1.0 };
+static const double kA[7][6] = {
+    {},
+    { 1.0 / 5 },
+    { 3.0 / 40, 9.0 / 40 },
+    { 44.0 / 45, -56.0 / 15, 32.0 / 9 },
+    { 19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729 },
+    { 9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656 },
+    { 35.0 / 384, 0.0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84 } };
+static const double kE[7] = { 71.0 / 57600, 0.0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200, 22.0 / 525, -1.0 / 40 };
+
+// One direction of a trajectory with the solver state needed to continue it.
+struct Branch {
+    int dir = 1;                    // +1 integrates towards +x
+    std::vector<double> xs, ys;     // accepted points, x monotonic in dir
+    long double x = 0, y = 0, h = 0, k1 = 0;
+    bool haveK1 = false;
+    bool stopped = false;
+};
+
+struct Trajectory {
+    double x0 = 0.0, y0 = 0.0;
+    Branch fwd, bwd;
+    double unit = 0.0;              // pixels per unit the tolerances were set for
+    unsigned epoch = 0;             // bumped on every restart of both branches
+};
+
+struct OdeLayer::Impl {
+    ExpressionSet set{ { { "x", 0 }, { "y", 1 } } };
+
+    std::vector<Trajectory> trajectories;
+    unsigned cacheGeneration = ~0u;
+    int cachePrecision = -1;
+
+    // slope field values and the grid they were evaluated on
+    struct FieldKey {
+        double gx0 = 0.0, gy0 = 0.0, step = 0.0;
+        int nx = 0, ny = 0, precision = -1;
+        unsigned generation = ~0u;
+        bool operator==(const FieldKey& o) const {
+            return gx0 == o.gx0 && gy0 == o.gy0 && step == o.step && nx == o.nx && ny == o.ny &&
+                precision == o.precision && generation == o.generation;
+        }
+    } slopeKey;
+    std::vector<float> slopes;
+    Stats stats;
+    double nsPerEval = 300.0;
+
+    static void Reset(Trajectory& t, double unit) {
+        t.unit = unit;
+        ++t.epoch;
+        for (Branch* b : { &t.fwd, &t.bwd }) {
+            b->xs.assign(1, t.x0);
+            b->ys.assign(1, t.y0);
+            b->x = t.x0;
+            b->y = t.y0;
+            b->h = 0;
+            b->haveK1 = false;
+            b->stopped = false;
+        }
+        t.fwd.dir = 1;
+        t.bwd.dir = -1;
+    }
+
+    // Halves a branch that reached kMaxPoints, keeping its first and last point.
+    static void Decimate(Branch& b) {
+        const size_t n = b.xs.size();
+        size_t m = 0;
+        for (size_t i = 0; i < n; i += 2, ++m) {
+            b.xs[m] = b.xs[i];
+            b.ys[m] = b.ys[i];
+        }
+        if ((n & 1) == 0) {
+            b.xs[m] = b.xs[n - 1];
+            b.ys[m] = b.ys[n - 1];
+            ++m;
+        }
+        b.xs.resize(m);
+        b.ys.resize(m);
+    }
+
+    // Advances `b` towards xEnd with at most maxSteps attempted steps.
+    template <typename T>
+    void Integrate(Evaluator<T>& ev, Branch& b, double xEnd, double unit, int maxSteps, int& accepted, int& rejected) {
+        auto f = [&](T x, T y) {
+            ev.vars[0] = x;
+            ev.vars[1] = y;
+            return ev.Value(0);
+        };
+        const T atol = T(kTolPx / unit);
+        const T hMax = T(kMaxStepPx / unit);
+        T x = T(b.x), y = T(b.y), h = T(b.h);
+        T k[7];
+        k[0] = b.haveK1 ? T(b.k1) : f(x, y);
+        if (!std::isfinite((double)k[0])) { b.stopped = true; return; }
+        if (!(h > T(0))) h = std::min(hMax, atol / std::max(T(std::fabs((double)k[0])), atol) * T(16));
+
+        for (int n = 0; n < maxSteps && b.dir * ((double)x - xEnd) < 0.0; ++n) {
+            h = std::min(h, hMax);
+            const T hs = h * T(b.dir);
+            for (int s = 1; s < 7; ++s) {
+                T acc = y;
+                for (int j = 0; j < s; ++j) acc += hs * T(kA[s][j]) * k[j];
+                k[s] = f(x + hs * T(kC[s]), acc);
+            }
+            T yNew = y;
+            T err = T(0);
+            for (int j = 0; j < 6; ++j) yNew += hs * T(kA[6][j]) * k[j];
+            for (int j = 0; j < 7; ++j) err += hs * T(kE[j]) * k[j];
+            const T scale = atol + T(kRelTol) * std::max(T(std::fabs((double)y)), T(std::fabs((double)yNew)));
+            const double e = std::fabs((double)(err / scale));
+
+            if (!std::isfinite(e) || !std::isfinite((double)yNew)) {
+                h *= T(0.25);
+                ++rejected;
+            }
+            else if (e <= 1.0) {
+                x += hs;
+                y = yNew;
+                k[0] = k[6];
+                ++accepted;
+                if (b.xs.size() >= kMaxPoints) Decimate(b);
+                b.xs.push_back((double)x);
+                b.ys.push_back((double)y);
+                h *= T(std::min(5.0, std::max(0.2, 0.9 * std::pow(std::max(e, 1e-10), -0.2))));
+            }
+            else {
+                h *= T(std::max(0.2, 0.9 * std::pow(e, -0.2)));
+                ++rejected;
+            }
+
+            // the solution left every representable range or the step collapsed (singularity, stiffness)
+            const double tiny = 1e-13 * std::max(1.0, std::fabs((double)x));
+            if (std::fabs((double)y) > 1e300 || (double)h < tiny) {
+                b.stopped = true;
+                break;
+            }
+        }
+        b.x = x;
+        b.y = y;
+        b.h = h;
+        b.k1 = k[0];
+        b.haveK1 = true;
+    }
+};
+
+OdeLayer::OdeLayer() : impl(std::make_unique<Impl>()) {}
+OdeLayer::~OdeLayer() = default;
+
+void OdeLayer::SetExpression(const std::string& expr) {
+    impl->set.SetSources({ expr });
+}
+
+bool OdeLayer::SetInitialConditions(const std::string& list) {
+    std::vector<std::pair<double, double>> ics;
+    std::string item;
+    std::istringstream items(list);
+    while (std::getline(items, item, ';')) {
+        if (item.find_first_not_of(" \t") == std::string::npos) continue;
+        std::replace(item.begin(), item.end(), ',', ' ');
+        std::istringstream iss(item);
+        double x0, y0;
+        std::string rest;
+        if (!(iss >> x0 >> y0) || (iss >> rest) || !std::isfinite(x0) || !std::isfinite(y0)) return false;
+        ics.push_back({ x0, y0 });
+    }
+
+    // keep the cached trajectories of conditions that are still listed
+    std::vector<Trajectory> next;
+    for (const auto& ic : ics) {
+        auto it = std::find_if(impl->trajectories.begin(), impl->trajectories.end(),
+            [&](const Trajectory& t) { return t.x0 == ic.first && t.y0 == ic.second; });
+        if (it != impl->trajectories.end()) next.push_back(std::move(*it));
+        else {
+            Trajectory t;
+            t.x0 = ic.first;
+            t.y0 = ic.second;
+            next.push_back(std::move(t));
+        }
+    }
+    impl->trajectories.swap(next);
+    return true;
+}
+
+bool OdeLayer::HasError() const {
+    return !impl->set.Valid();
+}
+
+const std::string& OdeLayer::GetLastError() const {
+    return impl->set.LastError();
+}
+
+const OdeLayer::Stats& OdeLayer::GetStats() const {
+    return impl->stats;
+}
+
+void OdeLayer::Draw(const Viewport& vp, const AppConfig& cfg) {
+    if (!cfg.showOde || !impl->set.Valid() || !(vp.unit > 0.0)) return;
+
+    // trajectories accumulate error along x, so never integrate in float
+    const int precision = std::max(ResolvePrecision(vp, cfg.precisionMode), (int)PRECISION_DOUBLE);
+    const bool reset = impl->cacheGeneration != impl->set.Generation() || impl->cachePrecision != precision;
+    impl->cacheGeneration = impl->set.Generation();
+    impl->cachePrecision = precision;
+
+    Stats& st = impl->stats;
+    st = Stats();
+    st.trajectories = (int)impl->trajectories.size();
+
+    const double margin = kMarginFrac * (vp.MaxX() - vp.MinX());
+    const double xLo = vp.MinX() - margin, xHi = vp.MaxX() + margin;
+
+    // 1. Branches that fall short of the view, extended from their end state.
+    // Extensions keep the tolerances of the unit the trajectory was reset at, so
+    // a branch never mixes step sizes; a zoom past kRefineZoom either way resets it.
+    struct Work { Branch* branch; double xEnd; double unit; };
+    std::vector<Work> work;
+    for (Trajectory& t : impl->trajectories) {
+        if (reset || t.fwd.xs.empty() || vp.unit > t.unit * kRefineZoom || vp.unit < t.unit / kRefineZoom)
+            Impl::Reset(t, vp.unit);
+        if (!t.fwd.stopped && t.fwd.x < xHi) work.push_back({ &t.fwd, xHi, t.unit });
+        if (!t.bwd.stopped && t.bwd.x > xLo) work.push_back({ &t.bwd, xLo, t.unit });
+    }
+
+    if (!work.empty()) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const int stepsEach = std::max(16, SampleBudget(cfg, impl->nsPerEval) / kEvalsPerStep / (int)work.size());
+        std::vector<int> accepted(work.size()), rejected(work.size());
+        WithPrecision(precision, [&](auto tag) {
+            using T = decltype(tag);
+            WorkerPool::Instance().ParallelFor((int)work.size(), 1, [&](int b, int e, unsigned w) {
+                Evaluator<T>& ev = impl->set.Acquire<T>(w);
+                if (!ev.valid) return;
+                for (int k = b; k < e; ++k)
+                    impl->Integrate(ev, *work[k].branch, work[k].xEnd, work[k].unit, stepsEach, accepted[k], rejected[k]);
+            });
+        });
+        for (size_t k = 0; k < work.size(); ++k) {
+            st.steps += accepted[k];
+            st.rejected += rejected[k];
+        }
+        const int evals = (st.steps + st.rejected) * kEvalsPerStep;
+        NoteEvalBatch(impl->nsPerEval, t0, evals);
+    }
+
+    ImDrawList* dl = ImGui::GetBackgroundDrawList();
+    const float left = vp.plotPos.x, top = vp.plotPos.y;
+    const float right = left + vp.plotSize.x, bottom = top + vp.plotSize.y;
+    dl->PushClipRect(vp.plotPos, ImVec2(right, bottom), true);
+
+    // 2. Slope field on a world-aligned grid, so arrows stay put while panning;
+    // it is evaluated again only when the grid or the expression changes.
+    if (cfg.showSlopeField) {
+        const double spacingPx = std::max(cfg.slopeSpacingPx, 8.0f);
+        const double step = std::ldexp(1.0, (int)std::ceil(std::log2(spacingPx / vp.unit)));
+        const double gx0 = std::ceil(vp.MinX() / step), gx1 = std::floor(vp.MaxX() / step);
+        const double gy0 = std::ceil(vp.MinY() / step), gy1 = std::floor(vp.MaxY() / step);
+        const int nx = (int)std::max(0.0, gx1 - gx0 + 1), ny = (int)std::max(0.0, gy1 - gy0 + 1);
+        Impl::FieldKey key;
+        key.gx0 = gx0;
+        key.gy0 = gy0;
+        key.step = step;
+        key.nx = nx;
+        key.ny = ny;
+        key.precision = ResolvePrecision(vp, cfg.precisionMode);
+        key.generation = impl->set.Generation();
+        if (nx > 0 && ny > 0 && (double)nx * ny < 1.0e6 && !(key == impl->slopeKey)) {
+            const auto t0 = std::chrono::steady_clock::now();
+            impl->slopeKey = key;
+            impl->slopes.resize((size_t)nx * ny);
+            WithPrecision(key.precision, [&](auto tag) {
+                using T = decltype(tag);
+                WorkerPool::Instance().ParallelFor(ny, 4, [&](int b, int e, unsigned w) {
+                    Evaluator<T>& ev = impl->set.Acquire<T>(w);
+                    for (int j = b; j < e; ++j) {
+                        float* row = impl->slopes.data() + (size_t)j * nx;
+                        ev.vars[1] = T((gy0 + j) * step);
+                        for (int i = 0; i < nx; ++i) {
+                            ev.vars[0] = T((gx0 + i) * step);
+                            row[i] = ev.valid ? (float)ev.Value(0) : std::numeric_limits<float>::quiet_NaN();
+                        }
+                    }
+                });
+            });
+            st.fieldEvals = nx * ny;
+            NoteEvalBatch(impl->nsPerEval, t0, st.fieldEvals);
+        }
+
+        if (nx > 0 && ny > 0 && key == impl->slopeKey) {
+            const ImU32 col = RGBA(cfg.slopeColor);
+            const float half = (float)(0.35 * step * vp.unit);
+            for (int j = 0; j < ny; ++j) {
+                const float sy = (float)vp.ToScreenY((gy0 + j) * step);
+                for (int i = 0; i < nx; ++i) {
+                    const float s = impl->slopes[(size_t)j * nx + i];
+                    if (!std::isfinite(s)) continue;
+                    const float sx = (float)vp.ToScreenX((gx0 + i) * step);
+                    // direction (1, s) in world units, y flipped on screen
+                    const float len = std::sqrt(1.0f + s * s);
+                    const float dx = half / len, dy = -half * s / len;
+                    const ImVec2 tip(sx + dx, sy + dy);
+                    dl->AddLine(ImVec2(sx - dx, sy - dy), tip, col);
+                    dl->AddLine(tip, ImVec2(tip.x - 0.35f * (dx + 0.5f * dy), tip.y - 0.35f * (dy - 0.5f * dx)), col);
+                    ++st.arrows;
+                }
+            }
+        }
+    }
+
+    // 3. Trajectories; only the points inside the x range of the view.
+    const ImU32 col = RGBA(cfg.odeColor);
+    for (const Trajectory& t : impl->trajectories) {
+        for (const Branch* b : { &t.bwd, &t.fwd }) {
+            st.points += b->xs.size();
+            if (b->stopped) ++st.stopped;
+            else if (b->dir * (b->x - (b->dir > 0 ? xHi : xLo)) < 0.0) ++st.pending;
+
+            const std::vector<double>& xs = b->xs;
+            size_t i0 = 0, i1 = xs.size();
+            if (b->dir > 0) {
+                i0 = std::lower_bound(xs.begin(), xs.end(), vp.MinX()) - xs.begin();
+                i1 = std::upper_bound(xs.begin(), xs.end(), vp.MaxX()) - xs.begin();
+            }
+            else {
+                i0 = std::lower_bound(xs.begin(), xs.end(), vp.MaxX(), std::greater<double>()) - xs.begin();
+                i1 = std::upper_bound(xs.begin(), xs.end(), vp.MinX(), std::greater<double>()) - xs.begin();
+            }
+            i0 = i0 > 0 ? i0 - 1 : 0;
+            i1 = std::min(i1 + 1, xs.size());
+
+            bool havePrev = false;
+            ImVec2 prev;
+            for (size_t i = i0; i < i1; ++i) {
+                const double py = vp.ToScreenY(b->ys[i]);
+                if (!std::isfinite(py)) {
+                    havePrev = false;
+                    continue;
+                }
+                const ImVec2 p(ClampToScreen(vp.ToScreenX(xs[i]), left, right), ClampToScreen(py, top, bottom));
+                if (havePrev) {
+                    const float dx = p.x - prev.x, dy = p.y - prev.y;
+                    if (dx * dx + dy * dy < 0.25f && i + 1 < i1) continue;
+                    dl->AddLine(prev, p, col, 2.0f);
+                }
+                prev = p;
+                havePrev = true;
+            }
+        }
+        const ImVec2 ic(ClampToScreen(vp.ToScreenX(t.x0), left, right), ClampToScreen(vp.ToScreenY(t.y0), top, bottom));
+        dl->AddCircleFilled(ic, 3.5f, col);
+    }
+    dl->PopClipRect();
+}
+
+void OdeLayer::Publish(PointIndex& index, int id, const AppConfig& cfg) const {
+    if (!cfg.showOde || !impl->set.Valid()) return;
+    char name[96];
+    for (const Trajectory& t : impl->trajectories) {
+        if (t.fwd.xs.empty() || t.bwd.xs.empty()) continue;
+        // branches only grow between restarts, so their lengths identify the points
+        const uint64_t version = ((uint64_t)t.epoch * 1000003u + t.fwd.xs.size()) * 1000003u + t.bwd.xs.size();
+        std::snprintf(name, sizeof(name), "y' = f(x, y) through (%g, %g)", t.x0, t.y0);
+        index.Publish(id++, name, RGBA(cfg.odeColor), true, version,
+            [&](std::vector<double>& xs, std::vector<double>& ys) {
+                // backward branch reversed, then forward; both start at (x0, y0)
+                xs.assign(t.bwd.xs.rbegin(), t.bwd.xs.rend());
+                ys.assign(t.bwd.ys.rbegin(), t.bwd.ys.rend());
+                xs.insert(xs.end(), t.fwd.xs.begin() + 1, t.fwd.xs.end());
+                ys.insert(ys.end(), t.fwd.ys.begin() + 1, t.fwd.ys.end());
+            });
+    }
+}
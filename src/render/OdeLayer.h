@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <cstddef>
+#include "Viewport.h"
+
+struct AppConfig;
+class PointIndex;
+
+// Solutions of y' = f(x, y) through a list of initial conditions, integrated
+// with adaptive Dormand-Prince RK45 forward and backward across the view,
+// plus a slope field of the same f. Each trajectory is cached per initial
+// condition and keeps its solver state, so panning only integrates the part
+// of the x axis that came into view.
+class OdeLayer {
+public:
+    struct Stats {
+        int trajectories = 0;
+        size_t points = 0;      // cached solution points, all trajectories
+        int steps = 0;          // accepted steps this frame
+        int rejected = 0;       // rejected steps this frame
+        int pending = 0;        // branches still short of the view edge
+        int stopped = 0;        // branches ended by blow-up or a vanishing step
+        int arrows = 0;
+        int fieldEvals = 0;     // slope field evaluations this frame
+    };
+
+    OdeLayer();
+    ~OdeLayer();
+
+    void SetExpression(const std::string& expr);
+    // "x0, y0; x0, y0; ..."; returns false and keeps the old list on a parse error.
+    bool SetInitialConditions(const std::string& list);
+    void Draw(const Viewport& vp, const AppConfig& cfg);
+    // Each solution as an x-sorted series of the readout index, ids from `id` up.
+    void Publish(PointIndex& index, int id, const AppConfig& cfg) const;
+
+    bool HasError() const;
+    const std::string& GetLastError() const;
+    const Stats& GetStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -0,0 +1,235 @@
+#include "PointIndex.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <chrono>
+
+// Consecutive samples per tree leaf. Curves are coherent along their
+// parameter, so a run of neighbours has a tight box.
+static constexpr size_t kRun = 16;
+
+namespace {
+
+struct Box {
+    double x0, y0, x1, y1;
+};
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr Box kEmpty = { kInf, kInf, -kInf, -kInf };
+
+// Squared distance from (x, y) to a box; infinite for an empty one.
+double BoxDist2(const Box& b, double x, double y) {
+    if (b.x0 > b.x1) return kInf;
+    const double dx = std::max({ b.x0 - x, 0.0, x - b.x1 });
+    const double dy = std::max({ b.y0 - y, 0.0, y - b.y1 });
+    return dx * dx + dy * dy;
+}
+
+bool Finite(double x, double y) {
+    return std::isfinite(x) && std::isfinite(y);
+}
+
+} // namespace
+
+struct PointIndex::Impl {
+    struct Series {
+        int id = 0;
+        std::string name;
+        ImU32 color = 0;
+        bool sortedX = false;
+        bool seen = false;
+        uint64_t version = ~0ull;
+        std::vector<double> xs, ys;
+        size_t leaves = 0;
+        size_t base = 1;            // first leaf node; nodes are 1-based, children 2i, 2i+1
+        std::vector<Box> tree;
+    };
+
+    std::vector<Series> series;
+    Stats stats;
+
+    const Series* Find(int id) const {
+        for (const Series& s : series)
+            if (s.id == id && s.seen) return &s;
+        return nullptr;
+    }
+
+    static void Build(Series& s) {
+        const size_t n = std::min(s.xs.size(), s.ys.size());
+        s.leaves = (n + kRun - 1) / kRun;
+        s.base = 1;
+        while (s.base < s.leaves) s.base *= 2;
+        s.tree.assign(2 * s.base, kEmpty);
+        for (size_t l = 0; l < s.leaves; ++l) {
+            Box& b = s.tree[s.base + l];
+            for (size_t i = l * kRun, e = std::min(n, i + kRun); i < e; ++i) {
+                if (!Finite(s.xs[i], s.ys[i])) continue;
+                b.x0 = std::min(b.x0, s.xs[i]);
+                b.x1 = std::max(b.x1, s.xs[i]);
+                b.y0 = std::min(b.y0, s.ys[i]);
+                b.y1 = std::max(b.y1, s.ys[i]);
+            }
+        }
+        for (size_t i = s.base - 1; i >= 1; --i) {
+            const Box& a = s.tree[2 * i];
+            const Box& b = s.tree[2 * i + 1];
+            s.tree[i] = { std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+        }
+    }
+
+    // Depth-first, nearer child first, pruning boxes no closer than the best so far.
+    static void Search(const Series& s, double x, double y, Hit& best, double& bestD2) {
+        if (s.leaves == 0) return;
+        size_t stack[128];
+        int top = 0;
+        stack[top++] = 1;
+        while (top > 0) {
+            const size_t node = stack[--top];
+            if (BoxDist2(s.tree[node], x, y) >= bestD2) continue;
+            if (node >= s.base) {
+                const size_t l = node - s.base;
+                for (size_t i = l * kRun, e = std::min(s.xs.size(), i + kRun); i < e; ++i) {
+                    const double dx = s.xs[i] - x, dy = s.ys[i] - y;
+                    const double d2 = dx * dx + dy * dy;
+                    if (d2 < bestD2) { // false for NaN
+                        bestD2 = d2;
+                        best.series = s.id;
+                        best.index = i;
+                        best.x = s.xs[i];
+                        best.y = s.ys[i];
+                    }
+                }
+                continue;
+            }
+            const size_t a = 2 * node, b = 2 * node + 1;
+            const bool aFirst = BoxDist2(s.tree[a], x, y) <= BoxDist2(s.tree[b], x, y);
+            stack[top++] = aFirst ? b : a;
+            stack[top++] = aFirst ? a : b;
+        }
+    }
+};
+
+PointIndex::PointIndex() : impl(std::make_unique<Impl>()) {}
+PointIndex::~PointIndex() = default;
+
+void PointIndex::BeginFrame() {
+    for (Impl::Series& s : impl->series) s.seen = false;
+    impl->stats.rebuilt = 0;
+}
+
+void PointIndex::Publish(int id, const std::string& name, ImU32 color, bool sortedX, uint64_t version, const Fill& fill) {
+    auto it = std::find_if(impl->series.begin(), impl->series.end(), [&](const Impl::Series& s) { return s.id == id; });
+    if (it == impl->series.end()) {
+        impl->series.emplace_back();
+        it = impl->series.end() - 1;
+        it->id = id;
+    }
+    Impl::Series& s = *it;
+    s.name = name;
+    s.color = color;
+    s.seen = true;
+    if (s.version == version && s.sortedX == sortedX) return;
+    s.version = version;
+    s.sortedX = sortedX;
+    s.xs.clear();
+    s.ys.clear();
+    fill(s.xs, s.ys);
+    s.ys.resize(s.xs.size(), std::numeric_limits<double>::quiet_NaN());
+    Impl::Build(s);
+    ++impl->stats.rebuilt;
+}
+
+void PointIndex::EndFrame() {
+    auto& v = impl->series;
+    v.erase(std::remove_if(v.begin(), v.end(), [](const Impl::Series& s) { return !s.seen; }), v.end());
+    impl->stats.series = (int)v.size();
+    impl->stats.points = 0;
+    for (const Impl::Series& s : v) impl->stats.points += s.xs.size();
+}
+
+bool PointIndex::Nearest(double x, double y, double maxDist, Hit& out, int series) {
+    const auto t0 = std::chrono::steady_clock::now();
+    Hit best;
+    double bestD2 = maxDist * maxDist;
+    for (const Impl::Series& s : impl->series)
+        if (s.seen && (series < 0 || s.id == series)) Impl::Search(s, x, y, best, bestD2);
+    impl->stats.queryUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    if (best.series < 0) return false;
+    best.dist = std::sqrt(bestD2);
+    out = best;
+    return true;
+}
+
+bool PointIndex::Snap(int series, double x, double y, Hit& out) {
+    const Impl::Series* s = impl->Find(series);
+    if (!s) return false;
+    if (!s->sortedX) return Nearest(x, y, kInf, out, series);
+
+    const size_t n = s->xs.size();
+    const size_t k = std::lower_bound(s->xs.begin(), s->xs.end(), x) - s->xs.begin();
+    // walk outwards from the insertion point to the first finite neighbours
+    size_t lo = k, hi = k;
+    while (lo > 0 && !Finite(s->xs[lo - 1], s->ys[lo - 1])) --lo;
+    while (hi < n && !Finite(s->xs[hi], s->ys[hi])) ++hi;
+    const bool haveLo = lo > 0, haveHi = hi < n;
+    if (!haveLo && !haveHi) return false;
+    const size_t i = (!haveLo || (haveHi && s->xs[hi] - x < x - s->xs[lo - 1])) ? hi : lo - 1;
+    out.series = series;
+    out.index = i;
+    out.x = s->xs[i];
+    out.y = s->ys[i];
+    out.dist = std::hypot(out.x - x, out.y - y);
+    return true;
+}
+
+bool PointIndex::Step(int series, size_t from, long long delta, Hit& out) const {
+    const Impl::Series* s = impl->Find(series);
+    if (!s || s->xs.empty()) return false;
+    const long long n = (long long)s->xs.size();
+    const long long target = std::clamp((long long)from + delta, 0ll, n - 1);
+    const long long dir = delta < 0 ? -1 : 1;
+    // past the target in the direction of travel, else back towards the start
+    long long i = target;
+    while (i >= 0 && i < n && !Finite(s->xs[i], s->ys[i])) i += dir;
+    if (i < 0 || i >= n) {
+        i = target;
+        while (i >= 0 && i < n && !Finite(s->xs[i], s->ys[i])) i -= dir;
+        if (i < 0 || i >= n) return false;
+    }
+    out.series = series;
+    out.index = (size_t)i;
+    out.x = s->xs[i];
+    out.y = s->ys[i];
+    out.dist = 0.0;
+    return true;
+}
+
+bool PointIndex::Has(int series) const {
+    return impl->Find(series) != nullptr;
+}
+
+size_t PointIndex::Size(int series) const {
+    const Impl::Series* s = impl->Find(series);
+    return s ? s->xs.size() : 0;
+}
+
+const char* PointIndex::Name(int series) const {
+    const Impl::Series* s = impl->Find(series);
+    return s ? s->name.c_str() : "";
+}
+
+ImU32 PointIndex::Color(int series) const {
+    const Impl::Series* s = impl->Find(series);
+    return s ? s->color : 0;
+}
+
+std::vector<int> PointIndex::Ids() const {
+    std::vector<int> ids;
+    for (const Impl::Series& s : impl->series)
+        if (s.seen) ids.push_back(s.id);
+    return ids;
+}
+
+const PointIndex::Stats& PointIndex::GetStats() const {
+    return impl->stats;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <imgui.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+// Nearest-point lookup over the world-space samples of everything drawn.
+// Each layer publishes its points as a series with a version; a series is
+// only copied and re-indexed when its version changes. Points are grouped
+// into runs of consecutive samples under a bounding-box tree, so a query
+// costs O(log n) per series no matter how many points it holds. Series
+// whose x is ascending also answer by-x lookups with a binary search.
+class PointIndex {
+public:
+    struct Hit {
+        int series = -1;        // id the series was published under
+        size_t index = 0;       // position in the series' point order
+        double x = 0.0, y = 0.0;
+        double dist = 0.0;      // world distance to the query point
+    };
+
+    struct Stats {
+        int series = 0;
+        size_t points = 0;
+        int rebuilt = 0;        // series re-indexed this frame
+        double queryUs = 0.0;   // last nearest-point query
+    };
+
+    PointIndex();
+    ~PointIndex();
+
+    using Fill = std::function<void(std::vector<double>& xs, std::vector<double>& ys)>;
+
+    // Series not published between BeginFrame and EndFrame are dropped.
+    void BeginFrame();
+    void Publish(int id, const std::string& name, ImU32 color, bool sortedX, uint64_t version, const Fill& fill);
+    void EndFrame();
+
+    // Nearest finite point within maxDist of (x, y); series < 0 searches all.
+    bool Nearest(double x, double y, double maxDist, Hit& out, int series = -1);
+    // Where a cursor at (x, y) lands on a series: the finite point closest
+    // in x for x-sorted series, closest in the plane otherwise.
+    bool Snap(int series, double x, double y, Hit& out);
+    // Finite point about `delta` samples away from `from` along a series,
+    // skipping gaps and clamped to its ends.
+    bool Step(int series, size_t from, long long delta, Hit& out) const;
+
+    bool Has(int series) const;
+    size_t Size(int series) const;
+    const char* Name(int series) const;
+    ImU32 Color(int series) const;
+    // Published series ids in publication order.
+    std::vector<int> Ids() const;
+
+    const Stats& GetStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
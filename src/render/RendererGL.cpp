@@ -3,6 +3,150 @@
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Windows' gl.h stops at OpenGL 1.1
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER         0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW          0x88E4
+#define GL_DYNAMIC_DRAW         0x88E8
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER      0x8B30
+#define GL_VERTEX_SHADER        0x8B31
+#define GL_COMPILE_STATUS       0x8B81
+#define GL_LINK_STATUS          0x8B82
+#endif
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER          0x8D40
+#define GL_RENDERBUFFER         0x8D41
+#define GL_COLOR_ATTACHMENT0    0x8CE0
+#define GL_DEPTH_ATTACHMENT     0x8D00
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24    0x81A6
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// OpenGL 2.0+ entry points of the 3-D view, resolved through GLFW so the
+// plain system gl.h is enough and no extension loader is needed.
+namespace {
+struct GL3 {
+    void (APIENTRY* GenBuffers)(GLsizei, GLuint*);
+    void (APIENTRY* DeleteBuffers)(GLsizei, const GLuint*);
+    void (APIENTRY* BindBuffer)(GLenum, GLuint);
+    void (APIENTRY* BufferData)(GLenum, std::ptrdiff_t, const void*, GLenum);
+    void (APIENTRY* BufferSubData)(GLenum, std::ptrdiff_t, std::ptrdiff_t, const void*);
+    void (APIENTRY* GenVertexArrays)(GLsizei, GLuint*);
+    void (APIENTRY* DeleteVertexArrays)(GLsizei, const GLuint*);
+    void (APIENTRY* BindVertexArray)(GLuint);
+    void (APIENTRY* VertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
+    void (APIENTRY* EnableVertexAttribArray)(GLuint);
+    GLuint (APIENTRY* CreateShader)(GLenum);
+    void (APIENTRY* ShaderSource)(GLuint, GLsizei, const char* const*, const GLint*);
+    void (APIENTRY* CompileShader)(GLuint);
+    void (APIENTRY* GetShaderiv)(GLuint, GLenum, GLint*);
+    void (APIENTRY* GetShaderInfoLog)(GLuint, GLsizei, GLsizei*, char*);
+    void (APIENTRY* DeleteShader)(GLuint);
+    GLuint (APIENTRY* CreateProgram)();
+    void (APIENTRY* AttachShader)(GLuint, GLuint);
+    void (APIENTRY* BindAttribLocation)(GLuint, GLuint, const char*);
+    void (APIENTRY* LinkProgram)(GLuint);
+    void (APIENTRY* GetProgramiv)(GLuint, GLenum, GLint*);
+    void (APIENTRY* GetProgramInfoLog)(GLuint, GLsizei, GLsizei*, char*);
+    void (APIENTRY* DeleteProgram)(GLuint);
+    void (APIENTRY* UseProgram)(GLuint);
+    GLint (APIENTRY* GetUniformLocation)(GLuint, const char*);
+    void (APIENTRY* UniformMatrix4fv)(GLint, GLsizei, GLboolean, const GLfloat*);
+    void (APIENTRY* Uniform1f)(GLint, GLfloat);
+    void (APIENTRY* Uniform2f)(GLint, GLfloat, GLfloat);
+    void (APIENTRY* Uniform3f)(GLint, GLfloat, GLfloat, GLfloat);
+    void (APIENTRY* Uniform4f)(GLint, GLfloat, GLfloat, GLfloat, GLfloat);
+    void (APIENTRY* DrawElementsBaseVertex)(GLenum, GLsizei, GLenum, const void*, GLint);
+} gl3;
+
+// OpenGL 3.0 framebuffer objects, for the offscreen target of replays.
+struct GLFbo {
+    void (APIENTRY* GenFramebuffers)(GLsizei, GLuint*);
+    void (APIENTRY* DeleteFramebuffers)(GLsizei, const GLuint*);
+    void (APIENTRY* BindFramebuffer)(GLenum, GLuint);
+    void (APIENTRY* FramebufferRenderbuffer)(GLenum, GLenum, GLenum, GLuint);
+    GLenum (APIENTRY* CheckFramebufferStatus)(GLenum);
+    void (APIENTRY* GenRenderbuffers)(GLsizei, GLuint*);
+    void (APIENTRY* DeleteRenderbuffers)(GLsizei, const GLuint*);
+    void (APIENTRY* BindRenderbuffer)(GLenum, GLuint);
+    void (APIENTRY* RenderbufferStorage)(GLenum, GLenum, GLsizei, GLsizei);
+} glFbo;
+
+template <typename F>
+bool LoadProc(F& fn, const char* name) {
+    fn = reinterpret_cast<F>(glfwGetProcAddress(name));
+    return fn != nullptr;
+}
+
+const char* kSurfaceVS = R"(#version 150
+in vec3 aPos;
+in vec2 aGrad;
+in float aSkirt;
+uniform mat4 uMvp;
+uniform vec2 uZ;
+uniform float uSkirt;
+out vec3 vNormal;
+out float vValid;
+out float vHeight;
+void main() {
+    bool ok = !(isnan(aPos.z) || isinf(aPos.z));
+    float h = ok ? clamp((aPos.z - uZ.x) * uZ.y, -2.0, 2.0) : 0.0;
+    vec2 g = clamp(aGrad * uZ.y, -1.0e4, 1.0e4);
+    vValid = ok ? 1.0 : 0.0;
+    vHeight = h;
+    vNormal = vec3(-g, 1.0);
+    gl_Position = uMvp * vec4(aPos.xy, h - aSkirt * uSkirt, 1.0);
+}
+)";
+
+// Vertices with non-finite z mark their triangles invalid; those are discarded.
+const char* kSurfaceFS = R"(#version 150
+in vec3 vNormal;
+in float vValid;
+in float vHeight;
+uniform vec4 uColor;
+uniform vec3 uLight;
+out vec4 outColor;
+void main() {
+    if (vValid < 0.999) discard;
+    float d = abs(dot(normalize(vNormal), uLight));
+    float tint = 0.85 + 0.15 * clamp(vHeight, -1.0, 1.0);
+    outColor = vec4(uColor.rgb * (0.25 + 0.75 * d) * tint, uColor.a);
+}
+)";
+
+GLuint CompileShader(GLenum type, const char* src) {
+    GLuint sh = gl3.CreateShader(type);
+    gl3.ShaderSource(sh, 1, &src, nullptr);
+    gl3.CompileShader(sh);
+    GLint ok = 0;
+    gl3.GetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024] = {};
+        gl3.GetShaderInfoLog(sh, sizeof(log), nullptr, log);
+        fprintf(stderr, "Surface shader: %s\n", log);
+        gl3.DeleteShader(sh);
+        return 0;
+    }
+    return sh;
+}
+} // namespace
 
 bool RendererGL::Init(GLFWwindow* window) {
     m_window = window;
@@ -10,29 +154,279 @@ bool RendererGL::Init(GLFWwindow* window) {
 
     glfwGetFramebufferSize(window, &m_width, &m_height);
     glViewport(0, 0, m_width, m_height);
-    
+
+    // the 2-D plot works without it, so a failure only disables the 3-D view
+    if (!Init3D()) fprintf(stderr, "3-D view unavailable: OpenGL 3.2 entry points or shaders missing\n");
+    return true;
+}
+
+bool RendererGL::Init3D() {
+    bool ok = true;
+    ok &= LoadProc(gl3.GenBuffers, "glGenBuffers");
+    ok &= LoadProc(gl3.DeleteBuffers, "glDeleteBuffers");
+    ok &= LoadProc(gl3.BindBuffer, "glBindBuffer");
+    ok &= LoadProc(gl3.BufferData, "glBufferData");
+    ok &= LoadProc(gl3.BufferSubData, "glBufferSubData");
+    ok &= LoadProc(gl3.GenVertexArrays, "glGenVertexArrays");
+    ok &= LoadProc(gl3.DeleteVertexArrays, "glDeleteVertexArrays");
+    ok &= LoadProc(gl3.BindVertexArray, "glBindVertexArray");
+    ok &= LoadProc(gl3.VertexAttribPointer, "glVertexAttribPointer");
+    ok &= LoadProc(gl3.EnableVertexAttribArray, "glEnableVertexAttribArray");
+    ok &= LoadProc(gl3.CreateShader, "glCreateShader");
+    ok &= LoadProc(gl3.ShaderSource, "glShaderSource");
+    ok &= LoadProc(gl3.CompileShader, "glCompileShader");
+    ok &= LoadProc(gl3.GetShaderiv, "glGetShaderiv");
+    ok &= LoadProc(gl3.GetShaderInfoLog, "glGetShaderInfoLog");
+    ok &= LoadProc(gl3.DeleteShader, "glDeleteShader");
+    ok &= LoadProc(gl3.CreateProgram, "glCreateProgram");
+    ok &= LoadProc(gl3.AttachShader, "glAttachShader");
+    ok &= LoadProc(gl3.BindAttribLocation, "glBindAttribLocation");
+    ok &= LoadProc(gl3.LinkProgram, "glLinkProgram");
+    ok &= LoadProc(gl3.GetProgramiv, "glGetProgramiv");
+    ok &= LoadProc(gl3.GetProgramInfoLog, "glGetProgramInfoLog");
+    ok &= LoadProc(gl3.DeleteProgram, "glDeleteProgram");
+    ok &= LoadProc(gl3.UseProgram, "glUseProgram");
+    ok &= LoadProc(gl3.GetUniformLocation, "glGetUniformLocation");
+    ok &= LoadProc(gl3.UniformMatrix4fv, "glUniformMatrix4fv");
+    ok &= LoadProc(gl3.Uniform1f, "glUniform1f");
+    ok &= LoadProc(gl3.Uniform2f, "glUniform2f");
+    ok &= LoadProc(gl3.Uniform3f, "glUniform3f");
+    ok &= LoadProc(gl3.Uniform4f, "glUniform4f");
+    ok &= LoadProc(gl3.DrawElementsBaseVertex, "glDrawElementsBaseVertex");
+    if (!ok) return false;
+
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, kSurfaceVS);
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, kSurfaceFS);
+    if (!vs || !fs) return false;
+    GLuint prog = gl3.CreateProgram();
+    gl3.AttachShader(prog, vs);
+    gl3.AttachShader(prog, fs);
+    gl3.BindAttribLocation(prog, 0, "aPos");
+    gl3.BindAttribLocation(prog, 1, "aGrad");
+    gl3.BindAttribLocation(prog, 2, "aSkirt");
+    gl3.LinkProgram(prog);
+    gl3.DeleteShader(vs);
+    gl3.DeleteShader(fs);
+    GLint linked = 0;
+    gl3.GetProgramiv(prog, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char log[1024] = {};
+        gl3.GetProgramInfoLog(prog, sizeof(log), nullptr, log);
+        fprintf(stderr, "Surface program: %s\n", log);
+        gl3.DeleteProgram(prog);
+        return false;
+    }
+    m_program = prog;
+    m_uMvp = gl3.GetUniformLocation(prog, "uMvp");
+    m_uZ = gl3.GetUniformLocation(prog, "uZ");
+    m_uSkirt = gl3.GetUniformLocation(prog, "uSkirt");
+    m_uColor = gl3.GetUniformLocation(prog, "uColor");
+    m_uLight = gl3.GetUniformLocation(prog, "uLight");
     return true;
 }
 
 void RendererGL::Cleanup() {
-    // Nothing specific to clean up for OpenGL in this simple case
+    ReleaseOffscreen();
+    for (unsigned tex : m_textures) {
+        GLuint id = tex;
+        glDeleteTextures(1, &id);
+    }
+    m_textures.clear();
+    while (!m_meshes.empty()) DestroyMesh(m_meshes.back().vao);
+    if (m_program) {
+        gl3.DeleteProgram(m_program);
+        m_program = 0;
+    }
     m_window = nullptr;
 }
 
+unsigned RendererGL::CreateTexture(int w, int h, bool repeat) {
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    m_textures.push_back(id);
+    return id;
+}
+
+void RendererGL::UpdateTexture(unsigned tex, int x, int y, int w, int h, const void* rgba) {
+    glBindTexture(GL_TEXTURE_2D, (GLuint)tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+}
+
+void RendererGL::DestroyTexture(unsigned tex) {
+    auto it = std::find(m_textures.begin(), m_textures.end(), tex);
+    if (it == m_textures.end()) return;
+    m_textures.erase(it);
+    GLuint id = tex;
+    glDeleteTextures(1, &id);
+}
+
+int RendererGL::MaxTextureSize() const {
+    GLint size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+    return size > 0 ? size : 2048;
+}
+
+void RendererGL::DrawTexture(unsigned tex, const ImVec2& clipMin, const ImVec2& clipMax,
+                             const ImVec2& pMin, const ImVec2& pMax, const ImVec2& uv0, const ImVec2& uv1, float alpha) {
+    ImDrawList* dl = ImGui::GetBackgroundDrawList();
+    dl->PushClipRect(clipMin, clipMax, true);
+    dl->AddImage((ImTextureID)(intptr_t)tex, pMin, pMax, uv0, uv1,
+                 IM_COL32(255, 255, 255, (int)(std::clamp(alpha, 0.0f, 1.0f) * 255)));
+    dl->PopClipRect();
+}
+
+unsigned RendererGL::CreateMesh(int vertexCapacity, const unsigned short* indices, int indexCount) {
+    if (!m_program) return 0;
+    Mesh m;
+    m.indexCount = indexCount;
+    gl3.GenVertexArrays(1, &m.vao);
+    gl3.GenBuffers(1, &m.vbo);
+    gl3.GenBuffers(1, &m.ebo);
+    gl3.BindVertexArray(m.vao);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, m.vbo);
+    gl3.BufferData(GL_ARRAY_BUFFER, (std::ptrdiff_t)vertexCapacity * kSurfaceVertexFloats * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+    gl3.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.ebo);
+    gl3.BufferData(GL_ELEMENT_ARRAY_BUFFER, (std::ptrdiff_t)indexCount * sizeof(unsigned short), indices, GL_STATIC_DRAW);
+    const GLsizei stride = kSurfaceVertexFloats * sizeof(float);
+    gl3.VertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (const void*)0);
+    gl3.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (const void*)(3 * sizeof(float)));
+    gl3.VertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (const void*)(5 * sizeof(float)));
+    for (GLuint a = 0; a < 3; ++a) gl3.EnableVertexAttribArray(a);
+    gl3.BindVertexArray(0);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+    m_meshes.push_back(m);
+    return m.vao;
+}
+
+void RendererGL::UpdateMesh(unsigned mesh, int firstVertex, int vertexCount, const float* vertices) {
+    auto it = std::find_if(m_meshes.begin(), m_meshes.end(), [&](const Mesh& m) { return m.vao == mesh; });
+    if (it == m_meshes.end()) return;
+    const std::ptrdiff_t bytes = kSurfaceVertexFloats * sizeof(float);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, it->vbo);
+    gl3.BufferSubData(GL_ARRAY_BUFFER, firstVertex * bytes, vertexCount * bytes, vertices);
+    gl3.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RendererGL::DestroyMesh(unsigned mesh) {
+    auto it = std::find_if(m_meshes.begin(), m_meshes.end(), [&](const Mesh& m) { return m.vao == mesh; });
+    if (it == m_meshes.end()) return;
+    gl3.DeleteBuffers(1, &it->vbo);
+    gl3.DeleteBuffers(1, &it->ebo);
+    gl3.DeleteVertexArrays(1, &it->vao);
+    m_meshes.erase(it);
+}
+
+void RendererGL::DrawMesh(unsigned mesh, const std::vector<int>& baseVertices, const SurfaceDrawParams& p) {
+    auto it = std::find_if(m_meshes.begin(), m_meshes.end(), [&](const Mesh& m) { return m.vao == mesh; });
+    if (it == m_meshes.end() || baseVertices.empty()) return;
+
+    // plot rect in framebuffer pixels, origin bottom-left
+    const ImVec2 fbScale = ImGui::GetIO().DisplayFramebufferScale;
+    const GLint x = (GLint)(p.clipMin.x * fbScale.x);
+    const GLint w = (GLint)((p.clipMax.x - p.clipMin.x) * fbScale.x);
+    const GLint h = (GLint)((p.clipMax.y - p.clipMin.y) * fbScale.y);
+    const GLint y = m_height - (GLint)(p.clipMin.y * fbScale.y) - h;
+    if (w <= 0 || h <= 0) return;
+
+    glViewport(x, y, w, h);
+    glScissor(x, y, w, h);
+    glEnable(GL_SCISSOR_TEST);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_BLEND);
+
+    gl3.UseProgram(m_program);
+    gl3.UniformMatrix4fv(m_uMvp, 1, GL_FALSE, p.mvp);
+    gl3.Uniform2f(m_uZ, p.zMid, p.zScale);
+    gl3.Uniform1f(m_uSkirt, p.skirtDepth);
+    gl3.Uniform4f(m_uColor, p.color.x, p.color.y, p.color.z, p.color.w);
+    gl3.Uniform3f(m_uLight, p.light[0], p.light[1], p.light[2]);
+    gl3.BindVertexArray(it->vao);
+    for (int base : baseVertices)
+        gl3.DrawElementsBaseVertex(GL_TRIANGLES, it->indexCount, GL_UNSIGNED_SHORT, nullptr, base);
+    gl3.BindVertexArray(0);
+    gl3.UseProgram(0);
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, m_width, m_height);
+}
+
 void RendererGL::BeginFrame(float r, float g, float b, float a) {
     if (!m_window) return;
     
+    if (m_fbo) {
+        glFbo.BindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        glViewport(0, 0, m_width, m_height);
+    }
     glClearColor(r, g, b, a);
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
 void RendererGL::EndFrame() {
     if (!m_window) return;
-    // Swap is handled by GLFW in the main loop
+    // Swap is handled by GLFW in the main loop; offscreen frames are waited
+    // for instead, so a frame's time includes its GPU work.
+    if (m_fbo) glFinish();
 }
 
 void RendererGL::OnResize(int w, int h) {
+    if (m_fbo) return; // the offscreen target keeps its own size
+    m_width = w;
+    m_height = h;
+    glViewport(0, 0, w, h);
+}
+
+bool RendererGL::SetOffscreen(int w, int h) {
+    if (m_fbo && w == m_width && h == m_height) return true;
+    if (w <= 0 || h <= 0) return false;
+    bool ok = true;
+    ok &= LoadProc(glFbo.GenFramebuffers, "glGenFramebuffers");
+    ok &= LoadProc(glFbo.DeleteFramebuffers, "glDeleteFramebuffers");
+    ok &= LoadProc(glFbo.BindFramebuffer, "glBindFramebuffer");
+    ok &= LoadProc(glFbo.FramebufferRenderbuffer, "glFramebufferRenderbuffer");
+    ok &= LoadProc(glFbo.CheckFramebufferStatus, "glCheckFramebufferStatus");
+    ok &= LoadProc(glFbo.GenRenderbuffers, "glGenRenderbuffers");
+    ok &= LoadProc(glFbo.DeleteRenderbuffers, "glDeleteRenderbuffers");
+    ok &= LoadProc(glFbo.BindRenderbuffer, "glBindRenderbuffer");
+    ok &= LoadProc(glFbo.RenderbufferStorage, "glRenderbufferStorage");
+    if (!ok) return false;
+
+    ReleaseOffscreen();
+    glFbo.GenRenderbuffers(2, m_fboBuffers);
+    glFbo.BindRenderbuffer(GL_RENDERBUFFER, m_fboBuffers[0]);
+    glFbo.RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glFbo.BindRenderbuffer(GL_RENDERBUFFER, m_fboBuffers[1]);
+    glFbo.RenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    glFbo.BindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFbo.GenFramebuffers(1, &m_fbo);
+    glFbo.BindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFbo.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_fboBuffers[0]);
+    glFbo.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_fboBuffers[1]);
+    if (glFbo.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        ReleaseOffscreen();
+        return false;
+    }
     m_width = w;
     m_height = h;
     glViewport(0, 0, w, h);
+    return true;
+}
+
+void RendererGL::ReleaseOffscreen() {
+    if (!m_fbo) return;
+    glFbo.BindFramebuffer(GL_FRAMEBUFFER, 0);
+    glFbo.DeleteFramebuffers(1, &m_fbo);
+    glFbo.DeleteRenderbuffers(2, m_fboBuffers);
+    m_fbo = 0;
+    m_fboBuffers[0] = m_fboBuffers[1] = 0;
 }
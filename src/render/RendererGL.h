@@ -9,8 +9,26 @@
     #include <GL/gl.h>
 #endif
 
+#include <imgui.h>
+#include <vector>
+
 struct GLFWwindow;
 
+// Per-draw state of a surface mesh. Vertices are kSurfaceVertexFloats floats:
+// u, v in [-1, 1], raw z, dz/du, dz/dv and skirt depth; the shader maps z
+// into the box with (z - zMid) * zScale so a new z range needs no upload.
+struct SurfaceDrawParams {
+    float mvp[16] = {};         // column-major
+    float zMid = 0.0f;
+    float zScale = 1.0f;
+    float skirtDepth = 0.25f;
+    ImVec4 color = ImVec4(1, 1, 1, 1);
+    float light[3] = { 0.0f, 0.0f, 1.0f };
+    ImVec2 clipMin, clipMax;    // plot rect in window coordinates
+};
+
+static constexpr int kSurfaceVertexFloats = 6;
+
 class RendererGL {
 public:
     RendererGL() = default;
@@ -24,10 +42,47 @@ public:
 
     void OnResize(int w, int h);
 
+    // Renders every frame into a w x h framebuffer object instead of the
+    // window, for replays in a hidden window or on a surfaceless context.
+    bool SetOffscreen(int w, int h);
+
     GLFWwindow* GetWindow() const { return m_window; }
 
+    // RGBA8 textures filled from the CPU; all are released in Cleanup().
+    unsigned CreateTexture(int w, int h, bool repeat);
+    void UpdateTexture(unsigned tex, int x, int y, int w, int h, const void* rgba);
+    void DestroyTexture(unsigned tex);
+    int MaxTextureSize() const;
+    // One textured quad in the background draw list, below grid and curves.
+    void DrawTexture(unsigned tex, const ImVec2& clipMin, const ImVec2& clipMax,
+                     const ImVec2& pMin, const ImVec2& pMax, const ImVec2& uv0, const ImVec2& uv1, float alpha);
+
+    // Indexed meshes for the 3-D view (OpenGL 3.2 core, GLSL 150). A mesh is
+    // a vertex buffer of fixed capacity and one index list shared by every
+    // patch; patches are drawn with glDrawElementsBaseVertex. Drawn straight
+    // to the framebuffer, under everything ImGui renders.
+    bool Has3D() const { return m_program != 0; }
+    unsigned CreateMesh(int vertexCapacity, const unsigned short* indices, int indexCount);
+    void UpdateMesh(unsigned mesh, int firstVertex, int vertexCount, const float* vertices);
+    void DestroyMesh(unsigned mesh);
+    void DrawMesh(unsigned mesh, const std::vector<int>& baseVertices, const SurfaceDrawParams& p);
+
 private:
+    bool Init3D();
+    void ReleaseOffscreen();
+
+    struct Mesh {
+        unsigned vao = 0, vbo = 0, ebo = 0;
+        int indexCount = 0;
+    };
+
     GLFWwindow* m_window = nullptr;
+    std::vector<unsigned> m_textures;
+    std::vector<Mesh> m_meshes;
+    unsigned m_program = 0;
+    int m_uMvp = -1, m_uZ = -1, m_uSkirt = -1, m_uColor = -1, m_uLight = -1;
+    unsigned m_fbo = 0;
+    unsigned m_fboBuffers[2] = {};  // color, depth
     int m_width = 0;
     int m_height = 0;
 };
\ No newline at end of file
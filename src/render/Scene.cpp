@@ -1,147 +1,501 @@
 #include "Scene.h"
+#include "Evaluator.h"
+#include "ImplicitLayer.h"
+#include "HeatmapLayer.h"
+#include "SurfaceView.h"
+#include "OdeLayer.h"
+#include "PointIndex.h"
+#include "ChebyshevProxy.h"
 #include "core/Config.h"
+#include "core/SpectrumAnalyzer.h"
 #include <cmath>
-#include <sstream>
-#include <exprtk.hpp>
+#include <cstdio>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <limits>
 
 static inline ImU32 RGBA(const ImVec4& c) {
     return IM_COL32(int(c.x * 255), int(c.y * 255), int(c.z * 255), int(c.w * 255));
 }
 
+// Upper bound on the points kept for one parametric/polar curve.
+static constexpr int kMaxCurvePoints = 1 << 20;
+// Longest screen-space chord a curve segment may keep before it is split.
+static constexpr double kMaxSegPx = 4.0;
+
 struct Scene::Impl {
-    using symbol_table_t = exprtk::symbol_table<float>;
-    using expression_t = exprtk::expression<float>;
-    using parser_t = exprtk::parser<float>;
-
-    symbol_table_t symbols;
-    expression_t   expression;
-    parser_t       parser;
-    float varX = 0.0f;
-    bool valid = false;
-    std::string lastError;
-
-    Impl() {
-        symbols.add_variable("x", varX);
-        symbols.add_constants();
-        expression.register_symbol_table(symbols);
+    ExpressionSet explicitSet{ { { "x", 0 } } };
+    ExpressionSet paramSet{ { { "t", 0 } } };
+    ExpressionSet polarSet{ { { "t", 0 }, { "theta", 0 } } };
+
+    ImplicitLayer implicit;
+    HeatmapLayer heatmap;
+    SurfaceView surface;
+    OdeLayer ode;
+    SpectrumAnalyzer spectrum;
+    ChebyshevProxy proxy;
+    bool proxyActive = false;           // explicit samples come from the proxy this frame
+    unsigned spectrumVersion = 0;       // sample version last handed to the analyzer
+    int spectrumWindow = -1;
+
+    // Progressive sampling state. Samples live on a nested uniform grid of N
+    // points; a pass at stride s has evaluated every s-th index (plus the last).
+    // Refinement halves the stride, evaluating only the new midpoints.
+    struct SampleCache {
+        double   x0 = 0.0, x1 = 0.0;    // world x of index 0 and N-1
+        int      N = 0;
+        int      iStart = 0;            // first index drawn (causal mode)
+        unsigned generation = ~0u;
+        int      precision = PRECISION_FLOAT;
+        std::vector<double> ys;
+        int  stride = 0;                // completed level
+        int  cursor = 0;                // next odd multiple of stride/2 to evaluate
+        bool converged = false;         // refinement stopped by tolerance
+        double maxDev = 0.0;            // max midpoint deviation of the running level (px)
+        unsigned version = 0;           // bumped whenever the completed samples change
+    } cache;
+
+    // Parametric/polar curves are kept in world space, sorted by t, and
+    // refined where the screen-space chord is long or the curve turns.
+    struct CurveCache {
+        int      mode = -1;
+        unsigned generation = ~0u;
+        double   t0 = 0.0, t1 = 0.0;
+        int      baseN = 0;
+        int      precision = PRECISION_FLOAT;
+        double   refinedUnit = 0.0;     // finest scale the points were refined for
+        std::vector<double> t, x, y;
+        unsigned version = 0;           // bumped whenever the points change
+    } curve;
+
+    // Everything drawn this frame, for the hover readout and trace cursor.
+    PointIndex points;
+    bool   tracing = false;
+    int    traceSeries = -1;
+    size_t traceIndex = 0;
+    double traceX = 0.0, traceY = 0.0;  // world position the cursor sits on
+    int    traceStep = 0, traceSeriesStep = 0; // moves queued for the next frame
+
+    bool  interacting = false;
+    double nsPerEval = 200.0;           // running estimate, seeded conservatively
+    double nsPerProxyEval = 20.0;       // same for a sample read from the proxy
+    double nsPerCurveEval = 400.0;
+    int   budgetSamples = 0;
+    int   activeSamples = 0;
+    int   targetSamples = 0;
+    int   activePrecision = PRECISION_FLOAT;
+    bool  curveActive = false;          // last draw was parametric/polar
+
+    // Visits the grid indices of `cache` that hold a sample: the completed
+    // level, the evaluated part of the running one and both ends.
+    template <typename F>
+    void ForEachSample(F&& f) const {
+        const SampleCache& c = cache;
+        const int N = c.N;
+        const int step = std::max(c.stride / 2, 1);
+        for (int i = c.iStart; i < N;) {
+            if (i == c.iStart || i == N - 1 || i % c.stride == 0 || i < c.cursor) f(i);
+            int next = (i / step + 1) * step;
+            if (next > N - 1 && i < N - 1) next = N - 1;
+            i = (next > i) ? next : N;
+        }
+    }
+
+    // Evaluates the explicit function at the given grid indices of `cache`,
+    // from the Chebyshev proxy where it has a piece that resolves the view.
+    // Returns how many of them needed the expression itself.
+    int EvalExplicit(const std::vector<int>& idx) {
+        if (!proxyActive) {
+            EvalDirect(idx);
+            return (int)idx.size();
+        }
+        if (idx.empty()) return 0;
+        const double span = cache.x1 - cache.x0;
+        const double denom = cache.N - 1;
+        std::vector<double> xs(idx.size()), ys(idx.size());
+        std::vector<unsigned char> direct(idx.size());
+        for (size_t k = 0; k < idx.size(); ++k) xs[k] = cache.x0 + span * (idx[k] / denom);
+        const auto t0 = std::chrono::steady_clock::now();
+        proxy.Evaluate(xs.data(), ys.data(), direct.data(), idx.size());
+        nsPerProxyEval = 0.8 * nsPerProxyEval + 0.2 * (ElapsedNs(t0) / idx.size());
+
+        std::vector<int> rest;
+        for (size_t k = 0; k < idx.size(); ++k) {
+            if (direct[k]) rest.push_back(idx[k]);
+            else cache.ys[idx[k]] = ys[k];
+        }
+        if (!rest.empty()) EvalDirect(rest);
+        return (int)rest.size();
+    }
+
+    // Evaluates the explicit expression itself at grid indices of `cache`.
+    void EvalDirect(const std::vector<int>& idx) {
+        const auto t0 = std::chrono::steady_clock::now();
+        WithPrecision(cache.precision, [&](auto tag) {
+            using T = decltype(tag);
+            const T x0 = T(cache.x0);
+            const T span = T(cache.x1) - T(cache.x0);
+            const T denom = T(cache.N - 1);
+            WorkerPool::Instance().ParallelFor((int)idx.size(), 64, [&](int b, int e, unsigned w) {
+                Evaluator<T>& ev = explicitSet.Acquire<T>(w);
+                for (int k = b; k < e; ++k) {
+                    const int i = idx[k];
+                    if (!ev.valid) { cache.ys[i] = 0.0; continue; }
+                    // the abscissa itself is formed at the view's precision
+                    ev.vars[0] = x0 + span * (T(i) / denom);
+                    cache.ys[i] = (double)ev.Value(0);
+                }
+            });
+        });
+        NoteEvalBatch(nsPerEval, t0, (double)idx.size());
+    }
+
+    // Evaluates the active curve at parameters ts, writing world points.
+    // Both components of a sample come from one assignment of t.
+    void EvalCurve(const std::vector<double>& ts, double* xs, double* ys) {
+        const bool polar = (curve.mode == CURVE_POLAR);
+        ExpressionSet& set = polar ? polarSet : paramSet;
+        WithPrecision(curve.precision, [&](auto tag) {
+            using T = decltype(tag);
+            WorkerPool::Instance().ParallelFor((int)ts.size(), 32, [&](int b, int e, unsigned w) {
+                Evaluator<T>& ev = set.Acquire<T>(w);
+                for (int k = b; k < e; ++k) {
+                    if (!ev.valid) { xs[k] = ys[k] = std::numeric_limits<double>::quiet_NaN(); continue; }
+                    const T t = T(ts[k]);
+                    ev.vars[0] = t;
+                    if (polar) {
+                        using std::cos; using std::sin;
+                        const T r = ev.Value(0);
+                        xs[k] = (double)(r * cos(t));
+                        ys[k] = (double)(r * sin(t));
+                    }
+                    else {
+                        xs[k] = (double)ev.Value(0);
+                        ys[k] = (double)ev.Value(1);
+                    }
+                }
+            });
+        });
     }
 };
 
+// Smallest 1-2-5 step (world units) whose on-screen spacing is at least minPx.
+static double NiceStep(double unit, double minPx) {
+    const double raw = minPx / unit;
+    const double mag = std::pow(10.0, std::floor(std::log10(raw)));
+    for (double m : { 1.0, 2.0, 5.0 })
+        if (m * mag >= raw) return m * mag;
+    return 10.0 * mag;
+}
+
+// Clamp before narrowing so far-off axes do not turn into inf/NaN floats.
+static float ClampToScreen(double v, float lo, float hi) {
+    return (float)std::clamp(v, (double)lo - 1.0e4, (double)hi + 1.0e4);
+}
+
 Scene::Scene() : impl(std::make_unique<Impl>()) {}
 Scene::~Scene() = default;   // now compiler sees full Impl type
 
 void Scene::SetExpression(const std::string& expr) {
-    impl->valid = impl->parser.compile(expr, impl->expression);
-    if (!impl->valid) {
-        std::ostringstream oss;
-        oss << "Parse error in expression: " << expr << "\n";
-        for (std::size_t i = 0; i < impl->parser.error_count(); ++i) {
-            auto e = impl->parser.get_error(i);
-            oss << "Error " << i
-                << " at pos " << e.token.position
-                << " [" << exprtk::parser_error::to_str(e.mode)
-                << "] " << e.diagnostic << "\n";
-        }
-        impl->lastError = oss.str();
-        //MessageBoxA(nullptr, oss.str().c_str(), "Expression Error", MB_OK | MB_ICONERROR);
-    }
-    else {
-        impl->lastError.clear();
-    }
+    impl->explicitSet.SetSources({ expr });
+}
+
+void Scene::SetParametric(const std::string& xExpr, const std::string& yExpr) {
+    impl->paramSet.SetSources({ xExpr, yExpr });
 }
 
-float Scene::Eval(float x) {
-    if (!impl->valid) return 0.0f;
-    impl->varX = x;
-    return impl->expression.value();
+void Scene::SetPolar(const std::string& rExpr) {
+    impl->polarSet.SetSources({ rExpr });
 }
 
-void Scene::DrawBackground(const ImVec2& plotPos, const ImVec2& plotSize, const AppConfig& cfg) {
-    const float centerX = plotPos.x + plotSize.x * 0.5f + (float)cfg.panX;
-    const float centerY = plotPos.y + plotSize.y * 0.5f + (float)cfg.panY;
-    const float step = cfg.gridSpacing * (std::max(cfg.gridScale, 1) / 100.0f); // pixels per world unit
+void Scene::DrawBackground(const Viewport& vp, const AppConfig& cfg) {
+    const ImVec2& plotPos = vp.plotPos;
+    const ImVec2& plotSize = vp.plotSize;
+    const float left = plotPos.x, right = plotPos.x + plotSize.x;
+    const float top = plotPos.y, bottom = plotPos.y + plotSize.y;
 
     ImDrawList* dl = ImGui::GetBackgroundDrawList();
-    dl->PushClipRect(plotPos, ImVec2(plotPos.x + plotSize.x, plotPos.y + plotSize.y), true);
+    dl->PushClipRect(plotPos, ImVec2(right, bottom), true);
     auto colGrid = IM_COL32(cfg.gridColor.x * 255, cfg.gridColor.y * 255, cfg.gridColor.z * 255, cfg.gridColor.w * 255);
     auto colAxis = IM_COL32(cfg.axisColor.x * 255, cfg.axisColor.y * 255, cfg.axisColor.z * 255, cfg.axisColor.w * 255);
 
-    const int iStartX = (int)std::floor((plotPos.x - centerX) / step);
-    const int iEndX   = (int)std::ceil((plotPos.x + plotSize.x - centerX) / step);
-    const int iStartY = (int)std::floor((plotPos.y - centerY) / step);
-    const int iEndY   = (int)std::ceil((plotPos.y + plotSize.y - centerY) / step);
+    // grid step in world units, kept at a readable pixel spacing at any zoom
+    const double step = NiceStep(vp.unit, 40.0);
+    const double kStartX = std::floor(vp.MinX() / step);
+    const double kStartY = std::floor(vp.MinY() / step);
+    const int countX = (int)std::min(std::ceil(vp.MaxX() / step) - kStartX, 1000.0);
+    const int countY = (int)std::min(std::ceil(vp.MaxY() / step) - kStartY, 1000.0);
+
+    // Significant digits needed to tell neighbouring ticks apart.
+    auto digitsFor = [&](double a, double b) {
+        const double maxAbs = std::max({ std::fabs(a), std::fabs(b), step });
+        return std::clamp((int)std::ceil(std::log10(maxAbs / step)) + 1, 1, 17);
+    };
+    const int digitsX = digitsFor(vp.MinX(), vp.MaxX());
+    const int digitsY = digitsFor(vp.MinY(), vp.MaxY());
 
     // vertical grid
-    for (int i = iStartX; i <= iEndX; ++i) {
-        float x = centerX + i * step;
-        dl->AddLine(ImVec2(x, plotPos.y), ImVec2(x, plotPos.y + plotSize.y), colGrid);
+    for (int j = 0; j <= countX; ++j) {
+        float x = (float)vp.ToScreenX((kStartX + j) * step);
+        dl->AddLine(ImVec2(x, top), ImVec2(x, bottom), colGrid);
     }
     // horizontal grid
-    for (int i = iStartY; i <= iEndY; ++i) {
-        float y = centerY + i * step;
-        dl->AddLine(ImVec2(plotPos.x, y), ImVec2(plotPos.x + plotSize.x, y), colGrid);
+    for (int j = 0; j <= countY; ++j) {
+        float y = (float)vp.ToScreenY((kStartY + j) * step);
+        dl->AddLine(ImVec2(left, y), ImVec2(right, y), colGrid);
     }
 
-    // axes
-    dl->AddLine(ImVec2(plotPos.x, centerY), ImVec2(plotPos.x + plotSize.x, centerY), colAxis);
-    dl->AddLine(ImVec2(centerX, plotPos.y), ImVec2(centerX, plotPos.y + plotSize.y), colAxis);
+    // axes; when the origin is off-screen, labels stick to the nearest edge
+    const double axisX = vp.ToScreenX(0.0);
+    const double axisY = vp.ToScreenY(0.0);
+    const bool showAxisX = axisY >= top && axisY <= bottom;
+    const bool showAxisY = axisX >= left && axisX <= right;
+    const float centerY = std::clamp(ClampToScreen(axisY, top, bottom), top, bottom - 24.0f);
+    const float centerX = std::clamp(ClampToScreen(axisX, left, right), left, right - 60.0f);
 
-    // arrows
-    dl->AddTriangleFilled({ plotPos.x + plotSize.x - 10, centerY - 5 }, { plotPos.x + plotSize.x, centerY }, { plotPos.x + plotSize.x - 10, centerY + 5 }, colAxis);
-    dl->AddTriangleFilled({ centerX - 5, plotPos.y + 10 }, { centerX, plotPos.y }, { centerX + 5, plotPos.y + 10 }, colAxis);
+    if (showAxisX) {
+        dl->AddLine(ImVec2(left, centerY), ImVec2(right, centerY), colAxis);
+        dl->AddTriangleFilled({ right - 10, centerY - 5 }, { right, centerY }, { right - 10, centerY + 5 }, colAxis);
+    }
+    if (showAxisY) {
+        dl->AddLine(ImVec2(centerX, top), ImVec2(centerX, bottom), colAxis);
+        dl->AddTriangleFilled({ centerX - 5, top + 10 }, { centerX, top }, { centerX + 5, top + 10 }, colAxis);
+    }
 
+    char label[64];
     // X ticks (world units)
-    for (int i = iStartX; i <= iEndX; ++i) {
-        if (i == 0) continue;
-        float x = centerX + i * step;
+    for (int j = 0; j <= countX; ++j) {
+        const double k = kStartX + j;
+        if (k == 0.0) continue;
+        float x = (float)vp.ToScreenX(k * step);
+        std::snprintf(label, sizeof(label), "%.*g", digitsX, k * step);
         dl->AddLine({ x, centerY - 5 }, { x, centerY + 5 }, colAxis);
-        dl->AddText({ x + 2, centerY + 10 }, colAxis, std::to_string(i).c_str());
+        dl->AddText({ x + 2, centerY + 10 }, colAxis, label);
     }
     // Y ticks (world units)
-    for (int i = iStartY; i <= iEndY; ++i) {
-        if (i == 0) continue;
-        float y = centerY + i * step;
+    for (int j = 0; j <= countY; ++j) {
+        const double k = kStartY + j;
+        if (k == 0.0) continue;
+        float y = (float)vp.ToScreenY(k * step);
+        std::snprintf(label, sizeof(label), "%.*g", digitsY, k * step);
         dl->AddLine({ centerX - 5, y }, { centerX + 5, y }, colAxis);
-        dl->AddText({ centerX + 10, y - 8 }, colAxis, std::to_string(-i).c_str());
+        dl->AddText({ centerX + 10, y - 8 }, colAxis, label);
     }
     dl->PopClipRect();
 }
 
-void Scene::DrawFunction(const ImVec2& center, const ImVec2& plotPos, const ImVec2& plotSize, const AppConfig& cfg) {
+ImplicitLayer& Scene::Implicit() {
+    return impl->implicit;
+}
+
+HeatmapLayer& Scene::Heatmap() {
+    return impl->heatmap;
+}
+
+SurfaceView& Scene::Surface() {
+    return impl->surface;
+}
+
+OdeLayer& Scene::Ode() {
+    return impl->ode;
+}
+
+SpectrumAnalyzer& Scene::Spectrum() {
+    return impl->spectrum;
+}
+
+const ChebyshevProxy& Scene::Proxy() const {
+    return impl->proxy;
+}
+
+void Scene::SetInteracting(bool interacting) {
+    impl->interacting = interacting;
+}
+
+int Scene::GetActiveSamples() const {
+    return impl->activeSamples;
+}
+
+int Scene::GetTargetSamples() const {
+    return impl->targetSamples;
+}
+
+int Scene::GetSampleBudget() const {
+    return impl->budgetSamples;
+}
+
+double Scene::GetEvalCostNs() const {
+    return impl->curveActive ? impl->nsPerCurveEval : impl->nsPerEval;
+}
+
+const char* Scene::GetActivePrecisionName() const {
+    return PrecisionName(impl->activePrecision);
+}
+
+void Scene::DrawFunction(const Viewport& vp, const AppConfig& cfg) {
+    if (!(vp.unit > 0.0)) return;
+    impl->curveActive = (cfg.curveMode == CURVE_PARAMETRIC || cfg.curveMode == CURVE_POLAR);
+    if (impl->curveActive)
+        DrawCurve(vp, cfg);
+    else
+        DrawExplicit(vp, cfg);
+}
+
+void Scene::DrawExplicit(const Viewport& vp, const AppConfig& cfg) {
     const int N = (cfg.samples > 2 ? cfg.samples : 2);
-    const float unit = cfg.gridSpacing * (std::max(cfg.gridScale, 1) / 100.0f); // pixels per world unit
-    if (unit <= 0.0f) return;
+    const double unit = vp.unit; // pixels per world unit
+
+    const ImVec2& plotPos = vp.plotPos;
+    const ImVec2& plotSize = vp.plotSize;
+    const bool causal = (cfg.sampleDomainMode == SAMPLE_DOMAIN_CAUSAL);
+    const float dxScreen = plotSize.x / (float)(N - 1);
+    const double x0 = vp.MinX();
+    const double x1 = vp.MaxX();
+    const int precision = ResolvePrecision(vp, cfg.precisionMode);
+    impl->activePrecision = precision;
+
+    // The proxy is fitted and evaluated in double; long double views need the expression.
+    impl->proxyActive = cfg.chebyshevProxy && precision != PRECISION_LONG_DOUBLE &&
+        impl->proxy.Prepare(impl->explicitSet, vp, cfg);
+
+    // The budget is counted in expression evaluations at their own cost: a
+    // sample read from the proxy is charged at the proxy's cost, and the
+    // proxy's fitting this frame comes off the top. Batches are sized as if
+    // every sample went to the expression, so a pan into a region the proxy
+    // cannot serve yet stays within the budget.
+    const int budget = SampleBudget(cfg, impl->nsPerEval);
+    const int proxyBudget = SampleBudget(cfg, impl->nsPerProxyEval);
+    impl->budgetSamples = budget;
+    double spent = impl->proxyActive ? (double)impl->proxy.GetStats().evaluated / budget : 0.0;
+    auto evaluate = [&](const std::vector<int>& idx) {
+        const int direct = impl->EvalExplicit(idx);
+        spent += (double)direct / budget + (double)((int)idx.size() - direct) / proxyBudget;
+    };
+    auto remaining = [&]() { return std::max((int)((1.0 - spent) * budget), 1); };
+
+    Impl::SampleCache& c = impl->cache;
+    std::vector<int> batch;
+    const bool viewChanged = c.x0 != x0 || c.x1 != x1 || c.N != N ||
+        c.generation != impl->explicitSet.Generation() || c.precision != precision;
+    if (viewChanged) {
+        // View changed: restart with the finest stride whose pass fits the budget.
+        c.x0 = x0;
+        c.x1 = x1;
+        c.N = N;
+        c.generation = impl->explicitSet.Generation();
+        c.precision = precision;
+        c.ys.assign(N, 0.0);
+        c.converged = false;
+        c.maxDev = 0.0;
+        ++c.version;
+
+        // first sample index where x_world >= 0 (small epsilon relative to the spacing)
+        c.iStart = 0;
+        if (causal) {
+            const double dxWorld = (x1 - x0) / (N - 1);
+            const double first = std::ceil((-1.0e-3 * dxWorld - x0) / dxWorld);
+            c.iStart = (int)std::clamp(first, 0.0, (double)N);
+        }
+
+        int stride = 1;
+        while ((N - 1) / stride + 1 > remaining()) stride *= 2;
+        c.stride = stride;
+        c.cursor = stride / 2;
+
+        for (int i = 0; i < N; i += stride) batch.push_back(i);
+        for (int i : { c.iStart, N - 1 })
+            if (i < N && i % stride != 0) batch.push_back(i);
+        evaluate(batch);
+    }
+    // Refine on idle frames; with the proxy serving, whatever the first pass
+    // left of the budget refines right away, even while interacting.
+    if ((impl->proxyActive || (!viewChanged && !impl->interacting)) && c.stride > 1 && !c.converged) {
+        while (c.stride > 1 && spent < 1.0) {
+            const int half = c.stride / 2;
+
+            // the part of this level's midpoints that fits the remaining budget
+            batch.clear();
+            int cursor = c.cursor;
+            const int room = remaining();
+            while (cursor < N - 1 && (int)batch.size() < room) {
+                if (cursor >= c.iStart) batch.push_back(cursor);
+                cursor += c.stride;
+            }
+            evaluate(batch);
+
+            for (int i : batch) {
+                // deviation of the new midpoint from the chord it replaces (px)
+                const int r = std::min(i + half, N - 1);
+                const double chord = 0.5 * (c.ys[i - half] + c.ys[r]);
+                const double dev = std::fabs(c.ys[i] - chord) * unit;
+                if (std::isfinite(dev)) c.maxDev = std::max(c.maxDev, dev);
+                else c.maxDev = std::numeric_limits<double>::infinity();
+            }
+            c.cursor = cursor;
+
+            if (c.cursor >= N - 1) {
+                // level complete
+                c.stride = half;
+                c.cursor = c.stride / 2;
+                ++c.version;
+                // only trust the tolerance once the level is dense enough to not alias
+                if ((N - 1) / c.stride >= 128 && c.maxDev < cfg.refineTolerancePx) {
+                    c.converged = true;
+                    break;
+                }
+                c.maxDev = 0.0;
+                if (c.stride == 1) break;
+            }
+        }
+    }
+
+    // The spectrum panel transforms the completed level as is: every
+    // stride-th sample is evaluated and uniformly spaced.
+    if (cfg.showSpectrum && (c.version != impl->spectrumVersion || cfg.spectrumWindow != impl->spectrumWindow)) {
+        const int first = (c.iStart + c.stride - 1) / c.stride * c.stride;
+        std::vector<double> samples;
+        if (first < N) samples.reserve((N - 1 - first) / c.stride + 1);
+        for (int i = first; i < N; i += c.stride) samples.push_back(c.ys[i]);
+        impl->spectrum.Submit(std::move(samples), (x1 - x0) / (N - 1) * c.stride, cfg.spectrumWindow, c.version);
+        impl->spectrumVersion = c.version;
+        impl->spectrumWindow = cfg.spectrumWindow;
+    }
 
     // Sample strictly across the visible viewport in screen space.
     std::vector<ImVec2> pts;
-    pts.reserve(N);
+    pts.reserve((N - 1) / std::max(c.stride / 2, 1) + 2);
 
-    const bool causal = (cfg.sampleDomainMode == SAMPLE_DOMAIN_CAUSAL);
-    
-    // In causal mode, find the screen position where x_world = 0
-    float xZeroScreen = center.x;
-    int iStart = 0;
-    if (causal) {
-        xZeroScreen = center.x; // x=0 in world space maps to center.x in screen space
-        // Find the first sample index where x_world >= 0
-        for (int i = 0; i < N; ++i) {
-            const float sx = plotPos.x + (float)i * (plotSize.x / (float)(N - 1));
-            const float x_world = (sx - center.x) / unit;
-            if (x_world >= -0.001f) { // small epsilon for floating point
-                iStart = i;
-                break;
+    // y is mapped relative to the view center in double, then narrowed
+    const double cy = vp.CenterY();
+    auto screenY = [&](double y) {
+        return ClampToScreen(cy - (y - vp.viewY) * unit, plotPos.y, plotPos.y + plotSize.y);
+    };
+
+    impl->ForEachSample([&](int i) { pts.emplace_back(plotPos.x + (float)i * dxScreen, screenY(c.ys[i])); });
+    impl->activeSamples = (int)pts.size();
+    impl->targetSamples = N - std::min(c.iStart, N);
+
+    // Denser than the screen (large sample counts for the spectrum): keep the
+    // first, lowest, highest and last point of every pixel column.
+    if (pts.size() > 4 * (size_t)plotSize.x) {
+        std::vector<ImVec2> env;
+        env.reserve(4 * (size_t)plotSize.x + 4);
+        size_t i = 0;
+        while (i < pts.size()) {
+            const float col = std::floor(pts[i].x);
+            size_t lo = i, hi = i, j = i;
+            for (; j < pts.size() && std::floor(pts[j].x) == col; ++j) {
+                if (pts[j].y < pts[lo].y) lo = j;
+                if (pts[j].y > pts[hi].y) hi = j;
             }
+            env.push_back(pts[i]);
+            env.push_back(pts[std::min(lo, hi)]);
+            env.push_back(pts[std::max(lo, hi)]);
+            env.push_back(pts[j - 1]);
+            i = j;
         }
-    }
-    
-    for (int i = iStart; i < N; ++i) {
-        const float sx = plotPos.x + (float)i * (plotSize.x / (float)(N - 1));
-        const float x_world = (sx - center.x) / unit;
-        const float y = Eval(x_world);
-        const float sy = center.y - y * unit;
-        pts.emplace_back(sx, sy);
+        pts.swap(env);
     }
 
     ImDrawList* dl = ImGui::GetBackgroundDrawList();
@@ -150,10 +504,301 @@ void Scene::DrawFunction(const ImVec2& center, const ImVec2& plotPos, const ImVe
     dl->PopClipRect();
 }
 
-bool Scene::HasError() const {
-    return !impl->valid;
+void Scene::DrawCurve(const Viewport& vp, const AppConfig& cfg) {
+    const int mode = cfg.curveMode;
+    ExpressionSet& set = (mode == CURVE_POLAR) ? impl->polarSet : impl->paramSet;
+    const int baseN = std::max(cfg.samples, 16);
+    const int precision = ResolvePrecision(vp, cfg.precisionMode);
+    impl->activePrecision = precision;
+
+    const int budget = SampleBudget(cfg, impl->nsPerCurveEval);
+    impl->budgetSamples = budget;
+
+    Impl::CurveCache& c = impl->curve;
+    std::vector<double> ts;
+    int evaluated = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // Points are world-space, so a pan keeps them; a large zoom-out resets
+    // to the base grid so the curve does not stay oversampled.
+    if (c.mode != mode || c.generation != set.Generation() || c.t0 != cfg.tMin || c.t1 != cfg.tMax ||
+        c.baseN != baseN || c.precision != precision || vp.unit < c.refinedUnit * 0.25) {
+        c.mode = mode;
+        c.generation = set.Generation();
+        c.t0 = cfg.tMin;
+        c.t1 = cfg.tMax;
+        c.baseN = baseN;
+        c.precision = precision;
+        c.refinedUnit = vp.unit;
+
+        const int n = std::min(baseN, std::max(budget, 16));
+        ts.resize(n);
+        for (int i = 0; i < n; ++i) ts[i] = c.t0 + (c.t1 - c.t0) * ((double)i / (n - 1));
+        c.t = ts;
+        ++c.version;
+        c.x.assign(n, 0.0);
+        c.y.assign(n, 0.0);
+        impl->EvalCurve(ts, c.x.data(), c.y.data());
+        evaluated += n;
+    }
+    c.refinedUnit = std::max(c.refinedUnit, vp.unit);
+
+    // Screen-space arc-length refinement: split segments whose chord is long,
+    // or whose turning angle implies a sagitta above the tolerance.
+    const double minDt = std::fabs(c.t1 - c.t0) * 1.0e-9;
+    const double left = vp.plotPos.x, right = left + vp.plotSize.x;
+    const double top = vp.plotPos.y, bottom = top + vp.plotSize.y;
+    std::vector<double> sx, sy, nx, ny, nt, mx, my;
+    std::vector<int> splits;
+    int pending = 0;
+    for (int pass = 0; pass < 16; ++pass) {
+        const int n = (int)c.t.size();
+        sx.resize(n);
+        sy.resize(n);
+        for (int i = 0; i < n; ++i) {
+            sx[i] = vp.ToScreenX(c.x[i]);
+            sy[i] = vp.ToScreenY(c.y[i]);
+        }
+        auto finite = [&](int i) { return std::isfinite(sx[i]) && std::isfinite(sy[i]); };
+        // turning angle at vertex i (0 at the ends or next to gaps)
+        auto turn = [&](int i) {
+            if (i <= 0 || i >= n - 1 || !finite(i - 1) || !finite(i) || !finite(i + 1)) return 0.0;
+            const double ax = sx[i] - sx[i - 1], ay = sy[i] - sy[i - 1];
+            const double bx = sx[i + 1] - sx[i], by = sy[i + 1] - sy[i];
+            return std::fabs(std::atan2(ax * by - ay * bx, ax * bx + ay * by));
+        };
+
+        splits.clear();
+        pending = 0;
+        const int room = std::min(budget - evaluated, kMaxCurvePoints - n);
+        for (int i = 0; i + 1 < n; ++i) {
+            if (!(std::fabs(c.t[i + 1] - c.t[i]) > minDt)) continue;
+            const bool fa = finite(i), fb = finite(i + 1);
+            bool split = false;
+            if (!fa || !fb) {
+                split = (fa != fb); // localize where the curve leaves its domain
+            }
+            else {
+                const double dx = sx[i + 1] - sx[i], dy = sy[i + 1] - sy[i];
+                const double len = std::sqrt(dx * dx + dy * dy);
+                // skip segments that cannot reach the plot rect
+                if (std::max(sx[i], sx[i + 1]) + len < left || std::min(sx[i], sx[i + 1]) - len > right ||
+                    std::max(sy[i], sy[i + 1]) + len < top || std::min(sy[i], sy[i + 1]) - len > bottom)
+                    continue;
+                if (len > kMaxSegPx) split = true;
+                else if (len > 0.5) split = len * std::max(turn(i), turn(i + 1)) * 0.25 > cfg.refineTolerancePx;
+            }
+            if (!split) continue;
+            if ((int)splits.size() < room) splits.push_back(i);
+            else ++pending;
+        }
+        if (splits.empty()) break;
+
+        ts.resize(splits.size());
+        for (size_t k = 0; k < splits.size(); ++k) ts[k] = 0.5 * (c.t[splits[k]] + c.t[splits[k] + 1]);
+        mx.resize(ts.size());
+        my.resize(ts.size());
+        impl->EvalCurve(ts, mx.data(), my.data());
+        evaluated += (int)ts.size();
+
+        // merge midpoints in after their segment's start
+        nt.clear(); nx.clear(); ny.clear();
+        nt.reserve(n + ts.size()); nx.reserve(n + ts.size()); ny.reserve(n + ts.size());
+        size_t k = 0;
+        for (int i = 0; i < n; ++i) {
+            nt.push_back(c.t[i]); nx.push_back(c.x[i]); ny.push_back(c.y[i]);
+            if (k < splits.size() && splits[k] == i) {
+                nt.push_back(ts[k]); nx.push_back(mx[k]); ny.push_back(my[k]);
+                ++k;
+            }
+        }
+        c.t.swap(nt);
+        c.x.swap(nx);
+        c.y.swap(ny);
+        ++c.version;
+        if (pending > 0) break; // budget spent
+    }
+    NoteEvalBatch(impl->nsPerCurveEval, t0, evaluated);
+
+    // Draw, dropping points closer than half a pixel to the last kept one.
+    ImDrawList* dl = ImGui::GetBackgroundDrawList();
+    dl->PushClipRect(vp.plotPos, ImVec2((float)right, (float)bottom), true);
+    const ImU32 col = RGBA(cfg.funcColor);
+    bool havePrev = false;
+    ImVec2 prev;
+    for (size_t i = 0; i < c.t.size(); ++i) {
+        const double px = vp.ToScreenX(c.x[i]);
+        const double py = vp.ToScreenY(c.y[i]);
+        if (!std::isfinite(px) || !std::isfinite(py)) {
+            havePrev = false;
+            continue;
+        }
+        const ImVec2 p(ClampToScreen(px, (float)left, (float)right), ClampToScreen(py, (float)top, (float)bottom));
+        if (havePrev) {
+            const float dx = p.x - prev.x, dy = p.y - prev.y;
+            if (dx * dx + dy * dy < 0.25f && i + 1 < c.t.size()) continue;
+            dl->AddLine(prev, p, col, 2.0f);
+        }
+        prev = p;
+        havePrev = true;
+    }
+    dl->PopClipRect();
+
+    impl->activeSamples = (int)c.t.size();
+    impl->targetSamples = (int)c.t.size() + pending;
+}
+
+// Series ids in the point index; each ODE solution takes one past kSeriesOde.
+enum { kSeriesFunction = 0, kSeriesImplicit = 1, kSeriesOde = 16 };
+
+void Scene::DrawReadout(const Viewport& vp, const AppConfig& cfg) {
+    if (!(vp.unit > 0.0)) return;
+    PointIndex& index = impl->points;
+
+    // 1. Publish this frame's points; unchanged series keep their index.
+    index.BeginFrame();
+    if (impl->curveActive) {
+        const Impl::CurveCache& c = impl->curve;
+        const bool valid = (c.mode == CURVE_POLAR) ? impl->polarSet.Valid() : impl->paramSet.Valid();
+        if (valid) {
+            index.Publish(kSeriesFunction, c.mode == CURVE_POLAR ? "r(t)" : "x(t), y(t)", RGBA(cfg.funcColor), false,
+                c.version, [&](std::vector<double>& xs, std::vector<double>& ys) {
+                    xs = c.x;
+                    ys = c.y;
+                });
+        }
+    }
+    else if (impl->explicitSet.Valid()) {
+        const Impl::SampleCache& c = impl->cache;
+        const uint64_t version = (uint64_t)c.version << 32 | (uint32_t)c.cursor;
+        index.Publish(kSeriesFunction, "f(x)", RGBA(cfg.funcColor), true, version,
+            [&](std::vector<double>& xs, std::vector<double>& ys) {
+                // the abscissa each sample was evaluated at, formed at its precision
+                WithPrecision(c.precision, [&](auto tag) {
+                    using T = decltype(tag);
+                    const T x0 = T(c.x0);
+                    const T span = T(c.x1) - T(c.x0);
+                    const T denom = T(c.N - 1);
+                    impl->ForEachSample([&](int i) {
+                        xs.push_back((double)(x0 + span * (T(i) / denom)));
+                        ys.push_back(c.ys[i]);
+                    });
+                });
+            });
+    }
+    impl->implicit.Publish(index, kSeriesImplicit, cfg);
+    impl->ode.Publish(index, kSeriesOde, cfg);
+    index.EndFrame();
+
+    ImDrawList* dl = ImGui::GetBackgroundDrawList();
+    const ImVec2 plotMax(vp.plotPos.x + vp.plotSize.x, vp.plotPos.y + vp.plotSize.y);
+    dl->PushClipRect(vp.plotPos, plotMax, true);
+    auto marker = [&](const PointIndex::Hit& h) {
+        const ImVec2 p = vp.ToScreen(h.x, h.y);
+        dl->AddCircleFilled(p, 4.0f, index.Color(h.series));
+        dl->AddCircle(p, 6.0f, IM_COL32(0, 0, 0, 200), 0, 1.5f);
+        return p;
+    };
+
+    // 2. Trace cursor: stays on its point while the series is unchanged and
+    // snaps back onto the series by position after it was resampled.
+    if (impl->tracing) {
+        const std::vector<int> ids = index.Ids();
+        PointIndex::Hit h;
+        bool have = false;
+        if (!ids.empty() && !index.Has(impl->traceSeries)) {
+            // start at the view center; after its series vanished, from where it was
+            if (impl->traceSeries < 0) {
+                impl->traceX = vp.viewX;
+                impl->traceY = vp.viewY;
+            }
+            impl->traceSeries = ids.front();
+            have = index.Snap(impl->traceSeries, impl->traceX, impl->traceY, h);
+        }
+        else if (index.Has(impl->traceSeries)) {
+            have = index.Step(impl->traceSeries, impl->traceIndex, 0, h) && h.x == impl->traceX && h.y == impl->traceY;
+            if (!have) have = index.Snap(impl->traceSeries, impl->traceX, impl->traceY, h);
+        }
+        if (have && impl->traceSeriesStep != 0 && ids.size() > 1) {
+            const int n = (int)ids.size();
+            const int k = (int)(std::find(ids.begin(), ids.end(), impl->traceSeries) - ids.begin());
+            const int next = ids[((k + impl->traceSeriesStep) % n + n) % n];
+            PointIndex::Hit g;
+            if (index.Snap(next, h.x, h.y, g)) h = g;
+        }
+        if (have && impl->traceStep != 0)
+            index.Step(h.series, h.index, impl->traceStep, h);
+        impl->traceStep = impl->traceSeriesStep = 0;
+
+        if (have) {
+            impl->traceSeries = h.series;
+            impl->traceIndex = h.index;
+            impl->traceX = h.x;
+            impl->traceY = h.y;
+
+            const ImVec2 p = marker(h);
+            char label[160];
+            std::snprintf(label, sizeof(label), "%s\nx = %.17g\ny = %.17g", index.Name(h.series), h.x, h.y);
+            const ImVec2 size = ImGui::CalcTextSize(label);
+            // beside the point, flipped inwards near the right and bottom edges
+            ImVec2 at(p.x + 10.0f, p.y + 10.0f);
+            if (at.x + size.x + 8.0f > plotMax.x) at.x = p.x - 10.0f - size.x - 8.0f;
+            if (at.y + size.y + 8.0f > plotMax.y) at.y = p.y - 10.0f - size.y - 8.0f;
+            dl->AddRectFilled(at, ImVec2(at.x + size.x + 8.0f, at.y + size.y + 8.0f), IM_COL32(255, 255, 255, 230), 3.0f);
+            dl->AddRect(at, ImVec2(at.x + size.x + 8.0f, at.y + size.y + 8.0f), index.Color(h.series), 3.0f);
+            dl->AddText(ImVec2(at.x + 4.0f, at.y + 4.0f), IM_COL32(0, 0, 0, 255), label);
+        }
+    }
+
+    // 3. Hover readout: nearest point within the radius of the mouse.
+    const ImGuiIO& io = ImGui::GetIO();
+    const ImVec2 m = io.MousePos;
+    const bool inPlot = m.x >= vp.plotPos.x && m.x < plotMax.x && m.y >= vp.plotPos.y && m.y < plotMax.y;
+    if (cfg.showReadout && inPlot && !io.WantCaptureMouse && !ImGui::IsAnyMouseDown()) {
+        PointIndex::Hit h;
+        if (index.Nearest(vp.ToWorldX(m.x), vp.ToWorldY(m.y), cfg.readoutRadiusPx / vp.unit, h)) {
+            marker(h);
+            ImGui::BeginTooltip();
+            ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(index.Color(h.series)), "%s", index.Name(h.series));
+            ImGui::Text("x = %.17g", h.x);
+            ImGui::Text("y = %.17g", h.y);
+            ImGui::EndTooltip();
+        }
+    }
+    dl->PopClipRect();
+}
+
+void Scene::ToggleTrace() {
+    impl->tracing = !impl->tracing;
+    impl->traceSeries = -1;
+    impl->traceStep = impl->traceSeriesStep = 0;
+}
+
+bool Scene::Tracing() const {
+    return impl->tracing;
 }
 
-const std::string& Scene::GetLastError() const {
-    return impl->lastError;
+void Scene::Trace(int pointStep, int seriesStep) {
+    impl->traceStep += pointStep;
+    impl->traceSeriesStep += seriesStep;
+}
+
+const PointIndex& Scene::Points() const {
+    return impl->points;
+}
+
+bool Scene::HasError(int curveMode) const {
+    switch (curveMode) {
+    case CURVE_PARAMETRIC: return !impl->paramSet.Valid();
+    case CURVE_POLAR:      return !impl->polarSet.Valid();
+    default:               return !impl->explicitSet.Valid();
+    }
+}
+
+const std::string& Scene::GetLastError(int curveMode) const {
+    switch (curveMode) {
+    case CURVE_PARAMETRIC: return impl->paramSet.LastError();
+    case CURVE_POLAR:      return impl->polarSet.LastError();
+    default:               return impl->explicitSet.LastError();
+    }
 }
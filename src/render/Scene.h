@@ -2,8 +2,16 @@
 #include <string>
 #include <imgui.h>
 #include <memory>
+#include "Viewport.h"
 
 struct AppConfig;
+class ImplicitLayer;
+class HeatmapLayer;
+class SurfaceView;
+class OdeLayer;
+class SpectrumAnalyzer;
+class PointIndex;
+class ChebyshevProxy;
 
 class Scene {
 public:
@@ -11,14 +19,52 @@ public:
     ~Scene();
 
     void SetExpression(const std::string& expr);
-    void DrawBackground(const ImVec2& plotPos, const ImVec2& plotSize, const AppConfig& cfg);
-    void DrawFunction(const ImVec2& center, const ImVec2& plotPos, const ImVec2& plotSize, const AppConfig& cfg);
+    void SetParametric(const std::string& xExpr, const std::string& yExpr);
+    void SetPolar(const std::string& rExpr);
+    void DrawBackground(const Viewport& vp, const AppConfig& cfg);
+    void DrawFunction(const Viewport& vp, const AppConfig& cfg);
 
-    bool HasError() const;
-    const std::string& GetLastError() const;
+    // While interacting (pan drag, zoom spring) only the budgeted coarse pass
+    // is drawn; refinement resumes on the following idle frames.
+    void SetInteracting(bool interacting);
+    int GetActiveSamples() const;
+    int GetTargetSamples() const;
+    int GetSampleBudget() const;
+    double GetEvalCostNs() const;
+    const char* GetActivePrecisionName() const;
+
+    // Overlay layers drawn on top of the function plot.
+    ImplicitLayer& Implicit();
+    OdeLayer& Ode();
+    // Field layer drawn underneath the grid.
+    HeatmapLayer& Heatmap();
+    // 3-D view, drawn instead of the 2-D layers in VIEW_3D.
+    SurfaceView& Surface();
+
+    // Spectrum of the explicit function's samples; fed by DrawFunction while
+    // cfg.showSpectrum is set.
+    SpectrumAnalyzer& Spectrum();
+    // Chebyshev fits the explicit function is resampled from while
+    // cfg.chebyshevProxy is set.
+    const ChebyshevProxy& Proxy() const;
+
+    // Hover tooltip and keyboard trace cursor, both snapping to the nearest
+    // point of anything drawn this frame; call after the 2-D layers.
+    void DrawReadout(const Viewport& vp, const AppConfig& cfg);
+    void ToggleTrace();
+    bool Tracing() const;
+    // Queues a move of the trace cursor by samples along its series and by
+    // series across the curves on screen.
+    void Trace(int pointStep, int seriesStep);
+    const PointIndex& Points() const;
+
+    // Errors of the expression set behind a CurveMode (explicit by default).
+    bool HasError(int curveMode = 0) const;
+    const std::string& GetLastError(int curveMode = 0) const;
 
 private:
-    float Eval(float x);
+    void DrawExplicit(const Viewport& vp, const AppConfig& cfg);
+    void DrawCurve(const Viewport& vp, const AppConfig& cfg);
 
     struct Impl;
     std::unique_ptr<Impl> impl;
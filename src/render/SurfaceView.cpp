@@ -0,0 +1,571 @@
+#include "SurfaceView.h"
+#include "Evaluator.h"
+#include "RendererGL.h"
+#include "core/Config.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static constexpr int kPatchQuads = 16;
+static constexpr int kPatchSide = kPatchQuads + 1;                  // vertices per patch edge
+static constexpr int kGridVerts = kPatchSide * kPatchSide;
+static constexpr int kPatchVerts = kGridVerts + 4 * kPatchSide;     // grid plus edge skirts
+static constexpr int kMaxLevel = 8;
+static constexpr int kMaxPatches = 1024;                            // vertex buffer slots
+static constexpr int kMaxDrawn = 640;                               // patches in one LOD cut
+static constexpr double kDomainPx = 1024.0;                         // domain width in 2-D plot pixels
+static constexpr float kFovY = 0.785398f;                           // 45 degrees
+static constexpr float kNear = 0.05f, kFar = 100.0f;
+
+// Patch (i, j) at level L covers u in -1 + [i, i + 1) * 2^(1-L), v likewise.
+struct PatchKey {
+    int level, i, j;
+    bool operator==(const PatchKey& o) const { return level == o.level && i == o.i && j == o.j; }
+};
+
+struct PatchKeyHash {
+    size_t operator()(const PatchKey& k) const {
+        return (size_t)(((uint64_t)(uint32_t)k.i << 32) ^ (uint64_t)(uint32_t)k.j * 0x9E3779B97F4A7C15ull ^ (uint64_t)k.level);
+    }
+};
+
+struct Patch {
+    int slot = -1;
+    float zmin = 0.0f, zmax = 0.0f;     // finite z extent, for the LOD distance
+    float zlo = 0.0f, zhi = 0.0f;       // 5th/95th percentile, used from the root
+    unsigned lastUse = 0;
+};
+
+static inline double PatchSize(int level) { return std::ldexp(2.0, -level); }
+
+// Column-major 4x4 helpers for the camera.
+static void Mul4(const float a[16], const float b[16], float out[16]) {
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r) {
+            float s = 0.0f;
+            for (int k = 0; k < 4; ++k) s += a[k * 4 + r] * b[c * 4 + k];
+            out[c * 4 + r] = s;
+        }
+}
+
+static void LookAt(const float eye[3], float out[16]) {
+    float f[3] = { -eye[0], -eye[1], -eye[2] };     // towards the box center
+    const float fl = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    for (float& v : f) v /= fl;
+    float s[3] = { f[1], -f[0], 0.0f };             // f x up, up = +z
+    const float sl = std::max(std::sqrt(s[0] * s[0] + s[1] * s[1]), 1e-6f);
+    s[0] /= sl; s[1] /= sl;
+    const float u[3] = { s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0] };
+    const float m[16] = {
+        s[0], u[0], -f[0], 0.0f,
+        s[1], u[1], -f[1], 0.0f,
+        s[2], u[2], -f[2], 0.0f,
+        -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]),
+        -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]),
+        (f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2]), 1.0f };
+    std::copy(m, m + 16, out);
+}
+
+static void Perspective(float aspect, float out[16]) {
+    const float f = 1.0f / std::tan(kFovY * 0.5f);
+    std::fill(out, out + 16, 0.0f);
+    out[0] = f / aspect;
+    out[5] = f;
+    out[10] = (kFar + kNear) / (kNear - kFar);
+    out[11] = -1.0f;
+    out[14] = 2.0f * kFar * kNear / (kNear - kFar);
+}
+
+// Index list shared by every patch: the grid, then one skirt strip per edge
+// hanging below it, which hides cracks between patches of different levels.
+static std::vector<unsigned short> PatchIndices() {
+    std::vector<unsigned short> idx;
+    auto quad = [&](int a, int b, int c, int d) {
+        idx.insert(idx.end(), { (unsigned short)a, (unsigned short)b, (unsigned short)c,
+                                (unsigned short)a, (unsigned short)c, (unsigned short)d });
+    };
+    for (int b = 0; b < kPatchQuads; ++b)
+        for (int a = 0; a < kPatchQuads; ++a)
+            quad(b * kPatchSide + a, b * kPatchSide + a + 1, (b + 1) * kPatchSide + a + 1, (b + 1) * kPatchSide + a);
+    for (int e = 0; e < 4; ++e) {
+        for (int k = 0; k < kPatchQuads; ++k) {
+            auto edge = [&](int n) {
+                switch (e) {
+                case 0:  return n;                                  // bottom
+                case 1:  return n * kPatchSide + kPatchQuads;       // right
+                case 2:  return kPatchQuads * kPatchSide + n;       // top
+                default: return n * kPatchSide;                     // left
+                }
+            };
+            const int skirt = kGridVerts + e * kPatchSide;
+            quad(edge(k), edge(k + 1), skirt + k + 1, skirt + k);
+        }
+    }
+    return idx;
+}
+
+// Where the patches of one cache live: the square [x +- half] x [y +- half]
+// evaluated at `precision`.
+struct PatchDomain {
+    double x = 0.0, y = 0.0, half = 0.0;
+    int precision = PRECISION_FLOAT;
+};
+
+// A patch built off the render thread, waiting for its upload.
+struct MeshedPatch {
+    PatchKey key;
+    Patch info;
+    std::vector<float> verts;           // kPatchVerts vertices
+};
+
+// Evaluates the patches `keys` of the domain and builds their vertices,
+// appending one MeshedPatch per key to `out`.
+static void MeshPatches(ExpressionSet& set, const PatchKey* keys, int n, const PatchDomain& dom,
+                        std::vector<MeshedPatch>& out) {
+    if (n <= 0) return;
+    std::vector<float> zbuf((size_t)n * kGridVerts);
+    const size_t first = out.size();
+    out.resize(first + n);
+    MeshedPatch* made = out.data() + first;
+
+    WithPrecision(dom.precision, [&](auto tag) {
+        using T = decltype(tag);
+        WorkerPool::Instance().ParallelFor(n * kPatchSide, 4, [&](int b, int e, unsigned w) {
+            Evaluator<T>& ev = set.Acquire<T>(w);
+            for (int r = b; r < e; ++r) {
+                const PatchKey& k = keys[r / kPatchSide];
+                const int row = r % kPatchSide;
+                float* z = zbuf.data() + (size_t)(r / kPatchSide) * kGridVerts + row * kPatchSide;
+                const double s = PatchSize(k.level);
+                const double v = -1.0 + s * (k.j + (double)row / kPatchQuads);
+                ev.vars[1] = T(dom.y + v * dom.half);
+                for (int a = 0; a < kPatchSide; ++a) {
+                    const double u = -1.0 + s * (k.i + (double)a / kPatchQuads);
+                    ev.vars[0] = T(dom.x + u * dom.half);
+                    z[a] = ev.valid ? (float)ev.Value(0) : std::numeric_limits<float>::quiet_NaN();
+                }
+            }
+        });
+    });
+
+    // vertices: u, v, z, dz/du, dz/dv, skirt; gradients by finite differences
+    WorkerPool::Instance().ParallelFor(n, 1, [&](int b, int e, unsigned) {
+        std::vector<float> finite;
+        for (int p = b; p < e; ++p) {
+            const PatchKey& k = keys[p];
+            const float* z = zbuf.data() + (size_t)p * kGridVerts;
+            made[p].key = k;
+            made[p].verts.resize((size_t)kPatchVerts * kSurfaceVertexFloats);
+            float* out = made[p].verts.data();
+            const double s = PatchSize(k.level);
+            const float step = (float)(s / kPatchQuads);
+            auto diff = [&](int i0, int i1, int n) {
+                const float d = (z[i1] - z[i0]) / (step * n);
+                return std::isfinite(d) ? d : 0.0f;
+            };
+            for (int row = 0; row < kPatchSide; ++row) {
+                for (int a = 0; a < kPatchSide; ++a) {
+                    const int i = row * kPatchSide + a;
+                    const int l = a > 0 ? i - 1 : i, r = a < kPatchQuads ? i + 1 : i;
+                    const int d = row > 0 ? i - kPatchSide : i, u = row < kPatchQuads ? i + kPatchSide : i;
+                    float* vtx = out + (size_t)i * kSurfaceVertexFloats;
+                    vtx[0] = (float)(-1.0 + s * (k.i + (double)a / kPatchQuads));
+                    vtx[1] = (float)(-1.0 + s * (k.j + (double)row / kPatchQuads));
+                    vtx[2] = z[i];
+                    vtx[3] = diff(l, r, (r - l));
+                    vtx[4] = diff(d, u, (u - d) / kPatchSide);
+                    vtx[5] = 0.0f;
+                }
+            }
+            const int edges[4][2] = { { 0, 1 }, { kPatchQuads, kPatchSide }, { kPatchQuads * kPatchSide, 1 }, { 0, kPatchSide } };
+            for (int e2 = 0; e2 < 4; ++e2) {
+                for (int m = 0; m < kPatchSide; ++m) {
+                    const int src = edges[e2][0] + m * edges[e2][1];
+                    float* vtx = out + (size_t)(kGridVerts + e2 * kPatchSide + m) * kSurfaceVertexFloats;
+                    std::copy(out + (size_t)src * kSurfaceVertexFloats, out + (size_t)(src + 1) * kSurfaceVertexFloats, vtx);
+                    vtx[5] = (float)s;
+                }
+            }
+
+            finite.clear();
+            for (int i = 0; i < kGridVerts; ++i)
+                if (std::isfinite(z[i])) finite.push_back(z[i]);
+            Patch& pt = made[p].info;
+            if (finite.empty()) continue;
+            const size_t cnt = finite.size();
+            pt.zmin = *std::min_element(finite.begin(), finite.end());
+            pt.zmax = *std::max_element(finite.begin(), finite.end());
+            std::nth_element(finite.begin(), finite.begin() + cnt / 20, finite.end());
+            pt.zlo = finite[cnt / 20];
+            std::nth_element(finite.begin(), finite.begin() + (cnt - 1 - cnt / 20), finite.end());
+            pt.zhi = finite[cnt - 1 - cnt / 20];
+        }
+    });
+}
+
+// Builds patch meshes on a thread of its own so a frame never waits for
+// them. The evaluation fans out to the worker pool a few patches at a time,
+// which keeps any ParallelFor of the frame from queueing long behind it, and
+// each group is handed back as soon as it is done. A new request replaces
+// the running one between groups. The mesher compiles its own copy of the
+// expression, so the render thread may recompile at any time.
+class PatchMesher {
+public:
+    struct Request {
+        std::string source;
+        PatchDomain domain;
+        unsigned epoch = 0;             // cache the patches belong to
+        std::vector<PatchKey> keys;     // in the order they are wanted
+    };
+
+    PatchMesher() { m_thread = std::thread(&PatchMesher::Loop, this); }
+    ~PatchMesher() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+    }
+
+    void Submit(Request&& req) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_request = std::move(req);
+            m_pending = true;
+        }
+        m_wake.notify_one();
+    }
+
+    // Moves out the patches finished since the last call, with the
+    // evaluation time they took, and the epoch they were built for.
+    void Take(std::vector<MeshedPatch>& out, double& elapsedNs, unsigned& epoch) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out.swap(m_done);
+        m_done.clear();
+        elapsedNs = m_doneNs;
+        m_doneNs = 0.0;
+        epoch = m_doneEpoch;
+    }
+
+    bool Busy() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pending || m_running;
+    }
+
+    // Blocks until every submitted patch is finished.
+    void Wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [&] { return !m_pending && !m_running; });
+    }
+
+private:
+    static constexpr int kGroup = 4;    // patches per ParallelFor
+
+    void Loop() {
+        Request req;
+        std::vector<MeshedPatch> made;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_running = false;
+                m_idle.notify_all();
+                m_wake.wait(lock, [&] { return m_quit || m_pending; });
+                if (m_quit) return;
+                std::swap(req, m_request);
+                m_pending = false;
+                m_running = true;
+            }
+            if (req.source != m_source) {
+                m_source = req.source;
+                m_set.SetSources({ m_source });
+            }
+            for (size_t g = 0; g < req.keys.size() && m_set.Valid(); g += kGroup) {
+                const int n = (int)std::min(req.keys.size() - g, (size_t)kGroup);
+                const auto t0 = std::chrono::steady_clock::now();
+                made.clear();
+                MeshPatches(m_set, req.keys.data() + g, n, req.domain, made);
+                const double ns = ElapsedNs(t0);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                // results of an older cache are of no use any more
+                if (m_doneEpoch != req.epoch) {
+                    m_done.clear();
+                    m_doneNs = 0.0;
+                    m_doneEpoch = req.epoch;
+                }
+                for (MeshedPatch& m : made) m_done.push_back(std::move(m));
+                m_doneNs += ns;
+                if (m_pending || m_quit) break;
+            }
+        }
+    }
+
+    ExpressionSet m_set{ { { "x", 0 }, { "y", 1 } } };
+    std::string m_source;
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake, m_idle;
+    bool m_quit = false;
+    bool m_pending = false;
+    bool m_running = false;
+    Request m_request;
+    std::vector<MeshedPatch> m_done;
+    double m_doneNs = 0.0;
+    unsigned m_doneEpoch = 0;
+};
+
+struct SurfaceView::Impl {
+    ExpressionSet set{ { { "x", 0 }, { "y", 1 } } };
+    std::string source;
+
+    std::unordered_map<PatchKey, Patch, PatchKeyHash> patches;
+    std::vector<int> freeSlots;
+    unsigned mesh = 0;
+    unsigned cacheGeneration = ~0u;
+    PatchDomain domain;
+    unsigned epoch = 0;                 // bumped whenever the cache is cleared
+    unsigned submittedEpoch = 0;        // of the mesher's latest request
+    unsigned frame = 0;
+
+    PatchMesher mesher;
+    std::vector<MeshedPatch> made;
+    std::vector<int> bases;
+
+    Stats stats;
+    double nsPerEval = 300.0;
+
+    void Clear() {
+        patches.clear();
+        freeSlots.clear();
+        for (int s = kMaxPatches - 1; s >= 0; --s) freeSlots.push_back(s);
+        ++epoch;
+    }
+
+    const Patch* Find(const PatchKey& k) const {
+        auto it = patches.find(k);
+        return it != patches.end() ? &it->second : nullptr;
+    }
+
+    // Takes a slot, evicting the least recently drawn patch if none is free.
+    // Patches drawn in the last frame stay: they are the current cut.
+    int AllocSlot() {
+        if (freeSlots.empty()) {
+            auto victim = patches.end();
+            for (auto it = patches.begin(); it != patches.end(); ++it) {
+                if (it->second.lastUse + 1 >= frame) continue;
+                if (victim == patches.end() || it->second.lastUse < victim->second.lastUse) victim = it;
+            }
+            if (victim == patches.end()) return -1;
+            freeSlots.push_back(victim->second.slot);
+            patches.erase(victim);
+        }
+        const int s = freeSlots.back();
+        freeSlots.pop_back();
+        return s;
+    }
+
+    // Uploads finished patches into free vertex buffer slots; the upload
+    // stays on the GL thread. Returns how many were taken in.
+    int Upload(std::vector<MeshedPatch>& list, RendererGL& renderer) {
+        int n = 0;
+        for (MeshedPatch& m : list) {
+            if (patches.count(m.key)) continue;
+            const int slot = AllocSlot();
+            if (slot < 0) break;
+            m.info.slot = slot;
+            m.info.lastUse = frame;
+            renderer.UpdateMesh(mesh, slot * kPatchVerts, kPatchVerts, m.verts.data());
+            patches[m.key] = m.info;
+            ++n;
+        }
+        return n;
+    }
+};
+
+SurfaceView::SurfaceView() : impl(std::make_unique<Impl>()) {
+    impl->Clear();
+}
+SurfaceView::~SurfaceView() = default;
+
+void SurfaceView::SetExpression(const std::string& expr) {
+    impl->source = expr;
+    impl->set.SetSources({ expr });
+}
+
+bool SurfaceView::HasError() const {
+    return !impl->set.Valid();
+}
+
+const std::string& SurfaceView::GetLastError() const {
+    return impl->set.LastError();
+}
+
+const SurfaceView::Stats& SurfaceView::GetStats() const {
+    return impl->stats;
+}
+
+void SurfaceView::Draw(const Viewport& vp, const AppConfig& cfg, RendererGL& renderer) {
+    Stats& st = impl->stats;
+    st = Stats();
+    st.supported = renderer.Has3D();
+    if (!st.supported || !impl->set.Valid() || !(vp.unit > 0.0) || vp.plotSize.x < 1.0f || vp.plotSize.y < 1.0f) return;
+    if (!impl->mesh) {
+        const std::vector<unsigned short> idx = PatchIndices();
+        impl->mesh = renderer.CreateMesh(kMaxPatches * kPatchVerts, idx.data(), (int)idx.size());
+        if (!impl->mesh) return;
+    }
+    ++impl->frame;
+
+    // domain: the square around the 2-D view center as wide as kDomainPx of
+    // the 2-D plot at its zoom, independent of the plot's size on screen
+    PatchDomain dom;
+    dom.precision = ResolvePrecision(vp, cfg.precisionMode);
+    dom.x = vp.viewX;
+    dom.y = vp.viewY;
+    dom.half = 0.5 * kDomainPx / vp.unit;
+    if (impl->cacheGeneration != impl->set.Generation() || impl->domain.precision != dom.precision ||
+        impl->domain.x != dom.x || impl->domain.y != dom.y || impl->domain.half != dom.half) {
+        impl->Clear();
+        impl->cacheGeneration = impl->set.Generation();
+        impl->domain = dom;
+    }
+
+    // Patches the mesher finished since the last frame; a replay waits for
+    // them so every run uploads the same patches on the same frame.
+    if (cfg.replaying) impl->mesher.Wait();
+    double meshNs = 0.0;
+    unsigned meshEpoch = 0;
+    impl->made.clear();
+    impl->mesher.Take(impl->made, meshNs, meshEpoch);
+    if (meshEpoch == impl->epoch && !impl->made.empty()) {
+        st.evaluated = impl->Upload(impl->made, renderer);
+        NoteEvalBatch(impl->nsPerEval, meshNs, (double)impl->made.size() * kGridVerts);
+    }
+
+    // The root sets the z scale and stands in until its children arrive, so
+    // it alone is built right here: one patch, once per domain.
+    const PatchKey root{ 0, 0, 0 };
+    if (!impl->Find(root)) {
+        const auto t0 = std::chrono::steady_clock::now();
+        impl->made.clear();
+        MeshPatches(impl->set, &root, 1, dom, impl->made);
+        impl->Upload(impl->made, renderer);
+        NoteEvalBatch(impl->nsPerEval, t0, kGridVerts);
+        ++st.evaluated;
+    }
+    const Patch* rp = impl->Find(root);
+    if (!rp) return;
+
+    // the root's robust z range fills [-height, height] of the box
+    const float zMid = 0.5f * (rp->zlo + rp->zhi);
+    float zHalf = 0.5f * (rp->zhi - rp->zlo);
+    if (!(zHalf > 1e-12f * std::max(1.0f, std::fabs(zMid)))) zHalf = 1.0f;
+    const float zScale = std::max(cfg.surfaceHeight, 0.01f) / zHalf;
+
+    const float pitch = std::clamp(cfg.camPitch, -1.55f, 1.55f);
+    const float dist = std::max(cfg.camDistance, 0.5f);
+    const float eye[3] = { dist * std::cos(pitch) * std::cos(cfg.camYaw),
+                           dist * std::cos(pitch) * std::sin(cfg.camYaw),
+                           dist * std::sin(pitch) };
+    const double focal = vp.plotSize.y / (2.0 * std::tan(kFovY * 0.5));
+
+    // on-screen size of one quad of the patch, from its nearest point
+    auto quadPx = [&](const PatchKey& k) {
+        const double s = PatchSize(k.level);
+        const double cu = -1.0 + s * (k.i + 0.5), cv = -1.0 + s * (k.j + 0.5);
+        double cz = 0.0, rz = 0.0;
+        if (const Patch* p = impl->Find(k)) {
+            cz = std::clamp((0.5 * (p->zmin + p->zmax) - zMid) * zScale, -2.0, 2.0);
+            rz = std::min(0.5 * (p->zmax - p->zmin) * zScale, 2.0);
+        }
+        const double dx = eye[0] - cu, dy = eye[1] - cv, dz = eye[2] - cz;
+        const double d = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - s * 0.7072 - rz, (double)kNear);
+        return s / kPatchQuads / d * focal;
+    };
+
+    // LOD cut, breadth first: a patch is replaced by its children only once
+    // all four are resident, so the surface never has holes.
+    const double detail = std::max(cfg.surfaceDetailPx, 1.0f);
+    std::vector<PatchKey> frontier{ root }, next, drawn;
+    std::vector<std::pair<double, PatchKey>> wanted;
+    int leaves = 1;
+    while (!frontier.empty()) {
+        next.clear();
+        for (const PatchKey& k : frontier) {
+            auto it = impl->patches.find(k);
+            if (it != impl->patches.end()) it->second.lastUse = impl->frame;
+            const double px = quadPx(k);
+            if (k.level < kMaxLevel && px > detail && leaves + 3 <= kMaxDrawn) {
+                PatchKey kids[4];
+                bool ready = true;
+                for (int c = 0; c < 4; ++c) {
+                    kids[c] = { k.level + 1, k.i * 2 + (c & 1), k.j * 2 + (c >> 1) };
+                    if (!impl->Find(kids[c])) {
+                        ready = false;
+                        wanted.push_back({ px, kids[c] });
+                    }
+                }
+                if (ready) {
+                    next.insert(next.end(), kids, kids + 4);
+                    leaves += 3;
+                    continue;
+                }
+            }
+            drawn.push_back(k);
+        }
+        frontier.swap(next);
+    }
+
+    // Coarse-to-fine by projected size, a frame's budget at a time. Until the
+    // mesher delivers, the resident parents of the wanted patches are drawn.
+    std::sort(wanted.begin(), wanted.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    const int budget = std::max(1, SampleBudget(cfg, impl->nsPerEval) / kGridVerts);
+    // a request for a cleared cache is replaced right away
+    const bool busy = impl->mesher.Busy() && impl->submittedEpoch == impl->epoch;
+    if (!busy && !wanted.empty()) {
+        PatchMesher::Request req;
+        req.source = impl->source;
+        req.domain = dom;
+        req.epoch = impl->epoch;
+        for (const auto& w : wanted) {
+            if ((int)req.keys.size() >= budget) break;
+            req.keys.push_back(w.second);
+        }
+        impl->mesher.Submit(std::move(req));
+        impl->submittedEpoch = impl->epoch;
+    }
+    st.meshing = busy || !wanted.empty();
+    st.pending = (int)wanted.size();
+
+    impl->bases.clear();
+    for (const PatchKey& k : drawn)
+        if (const Patch* p = impl->Find(k)) impl->bases.push_back(p->slot * kPatchVerts);
+    st.drawn = (int)impl->bases.size();
+    st.triangles = st.drawn * (kPatchQuads * kPatchQuads * 2 + 4 * kPatchQuads * 2);
+    st.cached = impl->patches.size();
+
+    SurfaceDrawParams p;
+    float view[16], proj[16];
+    LookAt(eye, view);
+    Perspective(vp.plotSize.x / vp.plotSize.y, proj);
+    Mul4(proj, view, p.mvp);
+    p.zMid = zMid;
+    p.zScale = zScale;
+    p.skirtDepth = 0.1f;
+    p.color = cfg.surfaceColor;
+    const float light[3] = { 0.3f, 0.5f, 0.81f };
+    std::copy(light, light + 3, p.light);
+    p.clipMin = vp.plotPos;
+    p.clipMax = ImVec2(vp.plotPos.x + vp.plotSize.x, vp.plotPos.y + vp.plotSize.y);
+    renderer.DrawMesh(impl->mesh, impl->bases, p);
+}
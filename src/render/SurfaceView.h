@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <cstddef>
+#include "Viewport.h"
+
+struct AppConfig;
+class RendererGL;
+
+// Rotatable 3-D surface z = f(x, y) over a square around the 2-D view
+// center whose width follows the 2-D zoom. The domain is a quadtree of
+// 16x16-quad patches; near patches are split until their quads project to
+// about the configured size, far ones stay coarse. Patches are built on a
+// background thread, uploaded at the start of a frame into a vertex buffer
+// of fixed slots and reused; until a patch's children arrive the patch
+// itself is drawn, so a frame never waits for the mesh.
+class SurfaceView {
+public:
+    struct Stats {
+        int drawn = 0;          // patches in the current LOD cut
+        int evaluated = 0;      // patches uploaded this frame
+        int pending = 0;        // patches the LOD wants but are not ready
+        bool meshing = false;   // the background mesher has work
+        size_t cached = 0;      // patches resident in the vertex buffer
+        int triangles = 0;
+        bool supported = true;  // false without OpenGL 3.2
+    };
+
+    SurfaceView();
+    ~SurfaceView();
+
+    void SetExpression(const std::string& expr);
+    void Draw(const Viewport& vp, const AppConfig& cfg, RendererGL& renderer);
+
+    bool HasError() const;
+    const std::string& GetLastError() const;
+    const Stats& GetStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
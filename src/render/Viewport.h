@@ -0,0 +1,28 @@
+#pragma once
+#include <imgui.h>
+
+// Maps double-precision world coordinates onto a screen-space plot rect.
+// The view is stored as the world point at the plot center plus a scale, so
+// panning far from the origin never accumulates pixel offsets.
+struct Viewport {
+    ImVec2 plotPos;
+    ImVec2 plotSize;
+    double viewX = 0.0;   // world x at plot center
+    double viewY = 0.0;   // world y at plot center
+    double unit = 50.0;   // pixels per world unit
+
+    double CenterX() const { return plotPos.x + plotSize.x * 0.5; }
+    double CenterY() const { return plotPos.y + plotSize.y * 0.5; }
+
+    double ToScreenX(double x) const { return CenterX() + (x - viewX) * unit; }
+    double ToScreenY(double y) const { return CenterY() - (y - viewY) * unit; }
+    double ToWorldX(double sx) const { return viewX + (sx - CenterX()) / unit; }
+    double ToWorldY(double sy) const { return viewY - (sy - CenterY()) / unit; }
+
+    double MinX() const { return ToWorldX(plotPos.x); }
+    double MaxX() const { return ToWorldX(plotPos.x + plotSize.x); }
+    double MinY() const { return ToWorldY(plotPos.y + plotSize.y); }
+    double MaxY() const { return ToWorldY(plotPos.y); }
+
+    ImVec2 ToScreen(double x, double y) const { return ImVec2((float)ToScreenX(x), (float)ToScreenY(y)); }
+};
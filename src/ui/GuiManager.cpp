@@ -1,11 +1,26 @@
 #include "GuiManager.h"
 #include "render/RendererGL.h"
 #include "render/Scene.h"
+#include "render/ImplicitLayer.h"
+#include "render/HeatmapLayer.h"
+#include "render/SurfaceView.h"
+#include "render/OdeLayer.h"
+#include "render/PointIndex.h"
+#include "render/ChebyshevProxy.h"
+#include "render/Dashboard.h"
 #include "core/Config.h"
+#include "core/Fft.h"
+#include "core/InputTrace.h"
 
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
 
 void GuiManager::Init(GLFWwindow* window, RendererGL& renderer) {
     IMGUI_CHECKVERSION();
@@ -21,10 +36,12 @@ void GuiManager::Shutdown() {
     ImGui::DestroyContext();
 }
 
-void GuiManager::BeginFrame() {
+void GuiManager::BeginFrame(InputTrace& trace) {
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
+    trace.BeforeNewFrame();
     ImGui::NewFrame();
+    trace.AfterNewFrame();
 }
 
 void GuiManager::EndFrame(RendererGL& renderer) {
@@ -34,7 +51,25 @@ void GuiManager::EndFrame(RendererGL& renderer) {
 
 static void HelpMarker(const char* d) { ImGui::SameLine(); ImGui::TextDisabled("(?)"); if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", d); }
 
-void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
+// Template with every standalone identifier `a` replaced by (value).
+static std::string SubstituteA(const char* tmpl, double value) {
+    char num[32];
+    std::snprintf(num, sizeof(num), "(%.6g)", value);
+    std::string out;
+    for (const char* p = tmpl; *p;) {
+        if (std::isalpha((unsigned char)*p) || *p == '_') {
+            const char* e = p;
+            while (std::isalnum((unsigned char)*e) || *e == '_') ++e;
+            if (e - p == 1 && *p == 'a') out += num;
+            else out.append(p, e);
+            p = e;
+        }
+        else out += *p++;
+    }
+    return out;
+}
+
+void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene, Dashboard& dashboard) {
     // Dockable control bar with fixed height/width per side, or floating window
     ImGuiViewport* vp = ImGui::GetMainViewport();
     const float topHeight = 130.0f;
@@ -67,19 +102,63 @@ void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
 
     if (ImGui::BeginTabBar("ControlTabs", ImGuiTabBarFlags_FittingPolicyResizeDown)) {
         if (ImGui::BeginTabItem("Function")) {
-            if (ImGui::InputTextWithHint("f(x)", "e.g. sin(x)", cfg.funcExprBuf(), cfg.funcExprBufSize(),
+            const char* modes[] = { "y = f(x)", "Parametric", "Polar" };
+            ImGui::Combo("Curve", &cfg.curveMode, modes, IM_ARRAYSIZE(modes));
+
+            if (cfg.curveMode == CURVE_PARAMETRIC) {
+                bool edited = false;
+                edited |= ImGui::InputTextWithHint("x(t)", "e.g. cos(3*t)", cfg.paramXExpr, cfg.funcExprBufSize(),
+                    ImGuiInputTextFlags_EnterReturnsTrue) || ImGui::IsItemDeactivatedAfterEdit();
+                edited |= ImGui::InputTextWithHint("y(t)", "e.g. sin(2*t)", cfg.paramYExpr, cfg.funcExprBufSize(),
+                    ImGuiInputTextFlags_EnterReturnsTrue) || ImGui::IsItemDeactivatedAfterEdit();
+                if (edited) scene.SetParametric(cfg.paramXExpr, cfg.paramYExpr);
+            }
+            else if (cfg.curveMode == CURVE_POLAR) {
+                if (ImGui::InputTextWithHint("r(theta)", "e.g. cos(4*theta)", cfg.polarExpr, cfg.funcExprBufSize(),
+                    ImGuiInputTextFlags_EnterReturnsTrue) ||
+                    ImGui::IsItemDeactivatedAfterEdit()) {
+                    scene.SetPolar(cfg.polarExpr);
+                }
+            }
+            else if (ImGui::InputTextWithHint("f(x)", "e.g. sin(x)", cfg.funcExprBuf(), cfg.funcExprBufSize(),
                 ImGuiInputTextFlags_EnterReturnsTrue) ||
                 ImGui::IsItemDeactivatedAfterEdit()) {
                 scene.SetExpression(cfg.funcExprBuf());
             }
-            if (scene.HasError()) ImGui::TextColored({ 1,0,0,1 }, "%s", scene.GetLastError().c_str());
+            if (scene.HasError(cfg.curveMode)) ImGui::TextColored({ 1,0,0,1 }, "%s", scene.GetLastError(cfg.curveMode).c_str());
+
+            if (cfg.curveMode != CURVE_EXPLICIT) {
+                ImGui::InputDouble("t min", &cfg.tMin, 0.0, 0.0, "%.6g");
+                ImGui::InputDouble("t max", &cfg.tMax, 0.0, 0.0, "%.6g");
+            }
 
             ImGui::ColorEdit4("Function color", (float*)&cfg.funcColor);
-            ImGui::DragInt("Samples", &cfg.samples, 1, 64, 16384);
-            HelpMarker("More samples = smoother line, but slower. 256–2048 is usually enough.");
+            ImGui::DragInt("Samples", &cfg.samples, 1, 64, SpectrumAnalyzer::kMaxSize);
+            HelpMarker("More samples = smoother line, but slower. 256–2048 is usually enough. "
+                "Parametric and polar curves start from this many t steps and refine by screen arc length.");
+            ImGui::DragFloat("Frame budget (ms)", &cfg.frameBudgetMs, 0.1f, 0.5f, 33.0f, "%.1f");
+            HelpMarker("Evaluation time per frame. While panning or zooming a coarse pass within this budget is drawn, then refined on idle frames.");
+            ImGui::DragFloat("Refine tolerance (px)", &cfg.refineTolerancePx, 0.01f, 0.0f, 4.0f, "%.2f");
+            ImGui::Text("Resolution %d / %d (budget %d, %.0f ns/eval)",
+                scene.GetActiveSamples(), scene.GetTargetSamples(), scene.GetSampleBudget(), scene.GetEvalCostNs());
+
+            if (cfg.curveMode == CURVE_EXPLICIT) ImGui::Checkbox("Spectrum", &cfg.showSpectrum);
+
+            if (cfg.curveMode == CURVE_EXPLICIT) {
+                ImGui::Checkbox("Chebyshev proxy", &cfg.chebyshevProxy);
+                HelpMarker("Fits f piecewise with Chebyshev polynomials once and resamples the fits after a pan or zoom. "
+                    "Pieces near poles, jumps or undefined regions fall back to evaluating f.");
+                if (cfg.chebyshevProxy) {
+                    ImGui::DragFloat("Proxy tolerance (px)", &cfg.proxyTolerancePx, 0.001f, 0.001f, 1.0f, "%.3f");
+                    const ChebyshevProxy::Stats& cs = scene.Proxy().GetStats();
+                    ImGui::Text("%d pieces (%d direct), degree <= %d, %d tiles (%d fitting)",
+                        cs.pieces, cs.direct, cs.maxDegree, cs.tiles, cs.fitting);
+                    ImGui::Text("Error <= %.3g (%.4f px), %.0f%% of samples direct", cs.error, cs.errorPx, 100.0 * cs.directShare);
+                }
+            }
 
             bool causal = (cfg.sampleDomainMode == SAMPLE_DOMAIN_CAUSAL);
-            if (ImGui::Checkbox("Start at x = 0 (causal)", &causal)) {
+            if (cfg.curveMode == CURVE_EXPLICIT && ImGui::Checkbox("Start at x = 0 (causal)", &causal)) {
                 cfg.sampleDomainMode = causal ? SAMPLE_DOMAIN_CAUSAL : SAMPLE_DOMAIN_SYMMETRIC;
             }
             ImGui::EndTabItem();
@@ -87,13 +166,191 @@ void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
 
         if (ImGui::BeginTabItem("View")) {
             ImGui::SliderInt("Grid spacing (px)", &cfg.gridSpacing, 1, 5000);
-            ImGui::SliderInt("Scale (%)", &cfg.gridScale, 10, 500);
+            double scale = cfg.gridScale;
+            if (ImGui::InputDouble("Scale (%)", &scale, 0.0, 0.0, "%.6g", ImGuiInputTextFlags_EnterReturnsTrue) && scale > 0.0)
+                cfg.gridScale = scale;
+            ImGui::InputDouble("Center x", &cfg.viewX, 0.0, 0.0, "%.17g");
+            ImGui::InputDouble("Center y", &cfg.viewY, 0.0, 0.0, "%.17g");
+
+            const char* precisions[] = { "Auto", "float", "double", "long double" };
+            ImGui::Combo("Precision", &cfg.precisionMode, precisions, IM_ARRAYSIZE(precisions));
+            HelpMarker("Auto picks the cheapest type that still resolves a pixel at the current view.");
+            ImGui::Text("Evaluating in %s", scene.GetActivePrecisionName());
+
+            ImGui::Checkbox("Hover readout", &cfg.showReadout);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(100.0f);
+            ImGui::SliderFloat("Radius (px)##readout", &cfg.readoutRadiusPx, 2.0f, 48.0f, "%.0f");
+            HelpMarker("Shows the exact sample nearest the mouse. T toggles a trace cursor: left/right steps along a curve, up/down switches curves.");
+            const PointIndex::Stats& ps = scene.Points().GetStats();
+            ImGui::Text("%zu points in %d series, query %.1f us", ps.points, ps.series, ps.queryUs);
+
+            const char* viewModes[] = { "2-D plot", "3-D surface" };
+            ImGui::Combo("Mode", &cfg.viewMode, viewModes, IM_ARRAYSIZE(viewModes));
+            if (cfg.viewMode == VIEW_3D) {
+                SurfaceView& surface = scene.Surface();
+                if (ImGui::InputTextWithHint("z(x, y)##surface", "e.g. sin(x)*cos(y)", cfg.surfaceExpr, cfg.funcExprBufSize(),
+                    ImGuiInputTextFlags_EnterReturnsTrue) ||
+                    ImGui::IsItemDeactivatedAfterEdit()) {
+                    surface.SetExpression(cfg.surfaceExpr);
+                }
+                if (surface.HasError()) ImGui::TextColored({ 1,0,0,1 }, "%s", surface.GetLastError().c_str());
+                ImGui::SliderFloat("Height", &cfg.surfaceHeight, 0.05f, 2.0f, "%.2f");
+                ImGui::SliderFloat("Mesh detail (px)", &cfg.surfaceDetailPx, 2.0f, 32.0f, "%.0f");
+                HelpMarker("Target on-screen size of one mesh quad; near patches are split until they reach it.");
+                ImGui::ColorEdit4("Surface color", (float*)&cfg.surfaceColor);
+                const SurfaceView::Stats& st = surface.GetStats();
+                if (!st.supported) ImGui::TextColored({ 1,0,0,1 }, "3-D view needs OpenGL 3.2");
+                ImGui::Text("%d patches, %d triangles, %d pending", st.drawn, st.triangles, st.pending);
+                ImGui::Text("%d evaluated, %zu cached%s", st.evaluated, st.cached, st.meshing ? ", meshing" : "");
+            }
             ImGui::ColorEdit4("Grid color", (float*)&cfg.gridColor);
             ImGui::ColorEdit4("Axis color", (float*)&cfg.axisColor);
             ImGui::ColorEdit4("Background", (float*)&cfg.backgroundColor);
             ImGui::EndTabItem();
         }
 
+        if (ImGui::BeginTabItem("Layers")) {
+            ImGui::Checkbox("Implicit f(x, y) = 0", &cfg.showImplicit);
+            ImplicitLayer& implicit = scene.Implicit();
+            if (ImGui::InputTextWithHint("f(x, y)", "e.g. x^2 + y^2 - 1", cfg.implicitExpr, cfg.funcExprBufSize(),
+                ImGuiInputTextFlags_EnterReturnsTrue) ||
+                ImGui::IsItemDeactivatedAfterEdit()) {
+                implicit.SetExpression(cfg.implicitExpr);
+            }
+            if (implicit.HasError()) ImGui::TextColored({ 1,0,0,1 }, "%s", implicit.GetLastError().c_str());
+            ImGui::ColorEdit4("Contour color", (float*)&cfg.implicitColor);
+            if (cfg.showImplicit) {
+                const ImplicitLayer::Stats& st = implicit.GetStats();
+                ImGui::Text("%d cells, %d segments%s", st.cells, st.segments, st.complete ? "" : " (refining)");
+                ImGui::Text("%d evaluated, %zu cached", st.evaluated, st.cached);
+            }
+
+            ImGui::Separator();
+            ImGui::Checkbox("ODE y' = f(x, y)", &cfg.showOde);
+            OdeLayer& ode = scene.Ode();
+            if (ImGui::InputTextWithHint("y'", "e.g. x - y^2", cfg.odeExpr, cfg.funcExprBufSize(),
+                ImGuiInputTextFlags_EnterReturnsTrue) ||
+                ImGui::IsItemDeactivatedAfterEdit()) {
+                ode.SetExpression(cfg.odeExpr);
+            }
+            if (ode.HasError()) ImGui::TextColored({ 1,0,0,1 }, "%s", ode.GetLastError().c_str());
+            static bool icError = false;
+            if (ImGui::InputTextWithHint("y(x0) = y0", "x0, y0; x0, y0", cfg.odeInitial, cfg.funcExprBufSize(),
+                ImGuiInputTextFlags_EnterReturnsTrue) ||
+                ImGui::IsItemDeactivatedAfterEdit()) {
+                icError = !ode.SetInitialConditions(cfg.odeInitial);
+            }
+            HelpMarker("Initial conditions as x0, y0 pairs separated by ';'. Each is integrated forward and backward across the view.");
+            if (icError) ImGui::TextColored({ 1,0,0,1 }, "Expected x0, y0 pairs separated by ';'");
+            ImGui::Checkbox("Slope field", &cfg.showSlopeField);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(120.0f);
+            ImGui::SliderFloat("Spacing", &cfg.slopeSpacingPx, 12.0f, 96.0f, "%.0f px");
+            ImGui::ColorEdit4("Solution color", (float*)&cfg.odeColor);
+            ImGui::ColorEdit4("Slope color", (float*)&cfg.slopeColor);
+            if (cfg.showOde) {
+                const OdeLayer::Stats& st = ode.GetStats();
+                ImGui::Text("%d solutions, %zu points, %d arrows (%d evaluated)", st.trajectories, st.points, st.arrows, st.fieldEvals);
+                ImGui::Text("%d steps (%d rejected), %d extending, %d stopped", st.steps, st.rejected, st.pending, st.stopped);
+            }
+
+            ImGui::Separator();
+            ImGui::Checkbox("Heatmap z = f(x, y)", &cfg.showHeatmap);
+            HeatmapLayer& heatmap = scene.Heatmap();
+            if (ImGui::InputTextWithHint("z(x, y)", "e.g. sin(x)*cos(y)", cfg.heatmapExpr, cfg.funcExprBufSize(),
+                ImGuiInputTextFlags_EnterReturnsTrue) ||
+                ImGui::IsItemDeactivatedAfterEdit()) {
+                heatmap.SetExpression(cfg.heatmapExpr);
+            }
+            if (heatmap.HasError()) ImGui::TextColored({ 1,0,0,1 }, "%s", heatmap.GetLastError().c_str());
+            const char* colormaps[] = { "Viridis", "Cool-warm", "Grayscale" };
+            ImGui::Combo("Colormap", &cfg.heatmapColormap, colormaps, IM_ARRAYSIZE(colormaps));
+            ImGui::SliderFloat("Opacity", &cfg.heatmapAlpha, 0.0f, 1.0f, "%.2f");
+            ImGui::SliderFloat("Pixel size", &cfg.heatmapPixel, 1.0f, 16.0f, "%.0f px");
+            HelpMarker("On-screen size of one field sample; the field is evaluated on a grid of this spacing.");
+            ImGui::Checkbox("Auto range", &cfg.heatmapAutoRange);
+            if (!cfg.heatmapAutoRange) {
+                ImGui::InputFloat("Min", &cfg.heatmapMin);
+                ImGui::InputFloat("Max", &cfg.heatmapMax);
+            }
+            if (cfg.showHeatmap) {
+                const HeatmapLayer::Stats& st = heatmap.GetStats();
+                ImGui::Text("Range [%.4g, %.4g], sample %.2f px", st.lo, st.hi, st.pixelPx);
+                ImGui::Text("%d tiles (%d preview), %d evaluated, %zu cached",
+                            st.visible, st.previews, st.evaluated, st.cached);
+            }
+            ImGui::EndTabItem();
+        }
+
+        if (ImGui::BeginTabItem("Dashboard")) {
+            ImGui::Checkbox("Show dashboard", &cfg.showDashboard);
+            HelpMarker("Grid of small y = f(x) plots with views of their own: drag to pan, wheel to zoom, R resets, "
+                "double-click focuses a pane. Shift+wheel scrolls a grid taller than the window.");
+            ImGui::SliderInt("Columns", &cfg.dashboardColumns, 0, 16, cfg.dashboardColumns == 0 ? "auto" : "%d");
+            ImGui::Checkbox("Link views", &cfg.dashboardLinked);
+            if (cfg.showDashboard) {
+                const Dashboard::Stats& st = dashboard.GetStats();
+                ImGui::Text("%d panes, %d visible, %d refining", st.panes, st.visible, st.dirty);
+                ImGui::Text("%d expressions, %d sample buffers", st.expressions, st.buffers);
+                ImGui::Text("%d evaluated (budget %d, %.0f ns/eval)", st.evaluated, st.budget, st.nsPerEval);
+            }
+
+            ImGui::Separator();
+            int remove = -1;
+            for (int i = 0; i < (int)cfg.panes.size(); ++i) {
+                ImGui::PushID(i);
+                // typed into a scratch buffer, so the dashboard does not compile
+                // every keystroke; the pane takes it on Enter or when focus leaves
+                char shown[sizeof(m_paneEdit)];
+                static_assert(sizeof(m_paneEdit) == sizeof(cfg.panes[i].expr), "pane buffer size");
+                char* buf = (i == m_paneEditing) ? m_paneEdit : shown;
+                if (buf == shown) std::snprintf(shown, sizeof(shown), "%s", cfg.panes[i].expr);
+                ImGui::SetNextItemWidth(-30.0f);
+                const bool commit = ImGui::InputText("##pane", buf, sizeof(m_paneEdit), ImGuiInputTextFlags_EnterReturnsTrue) ||
+                    ImGui::IsItemDeactivatedAfterEdit();
+                if (ImGui::IsItemActive() && m_paneEditing != i) {
+                    m_paneEditing = i;
+                    std::snprintf(m_paneEdit, sizeof(m_paneEdit), "%s", buf);
+                }
+                else if (!ImGui::IsItemActive() && m_paneEditing == i) {
+                    m_paneEditing = -1;
+                }
+                if (commit) std::snprintf(cfg.panes[i].expr, sizeof(cfg.panes[i].expr), "%s", buf);
+                ImGui::SameLine();
+                if (ImGui::SmallButton("x")) remove = i;
+                if (dashboard.HasError(i)) ImGui::TextColored({ 1,0,0,1 }, "%s", dashboard.GetLastError(i).c_str());
+                ImGui::PopID();
+            }
+            if (remove >= 0) {
+                cfg.panes.erase(cfg.panes.begin() + remove);
+                m_paneEditing = -1;
+            }
+            if (ImGui::Button("Add pane")) cfg.panes.push_back(DashboardPane());
+            ImGui::SameLine();
+            if (ImGui::Button("Clear")) {
+                cfg.panes.clear();
+                m_paneEditing = -1;
+            }
+
+            ImGui::Separator();
+            ImGui::InputText("Template", m_variantExpr, sizeof(m_variantExpr));
+            HelpMarker("Adds one pane per value of a, evenly spaced from the first to the last value.");
+            ImGui::InputFloat("a from", &m_variantFrom);
+            ImGui::InputFloat("a to", &m_variantTo);
+            ImGui::SliderInt("Count", &m_variantCount, 1, 64);
+            if (ImGui::Button("Add variants")) {
+                for (int k = 0; k < m_variantCount; ++k) {
+                    const double a = m_variantCount > 1
+                        ? m_variantFrom + (m_variantTo - m_variantFrom) * k / (m_variantCount - 1.0) : m_variantFrom;
+                    DashboardPane p;
+                    std::snprintf(p.expr, sizeof(p.expr), "%s", SubstituteA(m_variantExpr, a).c_str());
+                    cfg.panes.push_back(p);
+                }
+            }
+            ImGui::EndTabItem();
+        }
+
         if (ImGui::BeginTabItem("Prefs")) {
             if (ImGui::Button("Save")) cfg.Save("config.ini");
             ImGui::SameLine();
@@ -113,4 +370,85 @@ void GuiManager::ShowMainMenu(AppConfig& cfg, Scene& scene) {
 
     ImGui::End();
     ImGui::PopStyleVar(3);
-}
\ No newline at end of file
+}
+
+void GuiManager::ShowSpectrum(AppConfig& cfg, Scene& scene) {
+    if (!cfg.showSpectrum || cfg.curveMode != CURVE_EXPLICIT || cfg.viewMode != VIEW_2D) return;
+    scene.Spectrum().Poll(m_spectrum, m_spectrum.version);
+
+    ImGuiViewport* vp = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(vp->Pos.x + 20.0f, vp->Pos.y + vp->Size.y - 340.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(560.0f, 320.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Spectrum", &cfg.showSpectrum)) {
+        ImGui::End();
+        return;
+    }
+
+    const char* windows[] = { "Rectangular", "Hann", "Hamming", "Blackman" };
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::Combo("Window", &cfg.spectrumWindow, windows, IM_ARRAYSIZE(windows));
+    ImGui::SameLine();
+    ImGui::Checkbox("dB", &cfg.spectrumLogScale);
+    ImGui::SameLine();
+    ImGui::Checkbox("Phase", &cfg.spectrumShowPhase);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::SliderFloat("Range", &cfg.spectrumRange, 0.01f, 1.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+
+    const SpectrumAnalyzer::Result& r = m_spectrum;
+    ImGui::Text("%d samples -> %d-point FFT (%s), %.2f ms%s", r.samples, r.size, RealFft::Backend(), r.ms,
+        scene.Spectrum().Busy() ? ", updating" : "");
+    if (r.nonFinite > 0) ImGui::TextColored({ 1,0,0,1 }, "%d non-finite samples set to 0", r.nonFinite);
+    if (r.magnitude.size() < 2) {
+        ImGui::End();
+        return;
+    }
+
+    // one column per pixel, showing the strongest bin it covers
+    const ImVec2 avail = ImGui::GetContentRegionAvail();
+    const int plots = cfg.spectrumShowPhase ? 2 : 1;
+    const float plotH = std::max((avail.y - 4.0f * plots) / plots, 40.0f);
+    const int width = std::max((int)avail.x, 16);
+    const int bins = std::max(2, (int)(r.magnitude.size() * std::clamp(cfg.spectrumRange, 0.0f, 1.0f)));
+    std::vector<int> peak(width, -1);
+    for (int c = 0; c < width; ++c) {
+        const int k0 = (int)((long long)c * bins / width), k1 = std::max(k0 + 1, (int)((long long)(c + 1) * bins / width));
+        for (int k = k0; k < k1 && k < bins; ++k)
+            if (peak[c] < 0 || r.magnitude[k] > r.magnitude[peak[c]]) peak[c] = k;
+    }
+    const float maxMag = *std::max_element(r.magnitude.begin(), r.magnitude.begin() + bins);
+    auto value = [&](int k) {
+        if (!cfg.spectrumLogScale) return maxMag > 0.0f ? r.magnitude[k] / maxMag : 0.0f;
+        const float db = 20.0f * std::log10(std::max(r.magnitude[k] / std::max(maxMag, 1e-30f), 1e-6f));
+        return 1.0f + db / 120.0f;  // -120 dB .. 0 dB
+    };
+
+    ImDrawList* dl = ImGui::GetWindowDrawList();
+    const ImU32 colLine = ImGui::GetColorU32(ImGuiCol_PlotLines);
+    const ImU32 colFrame = ImGui::GetColorU32(ImGuiCol_FrameBg);
+    for (int p = 0; p < plots; ++p) {
+        const ImVec2 p0 = ImGui::GetCursorScreenPos();
+        const ImVec2 p1(p0.x + width, p0.y + plotH);
+        ImGui::InvisibleButton(p == 0 ? "##magnitude" : "##phase", ImVec2((float)width, plotH));
+        const bool hovered = ImGui::IsItemHovered();
+        dl->AddRectFilled(p0, p1, colFrame);
+        ImVec2 prev;
+        for (int c = 0; c < width; ++c) {
+            if (peak[c] < 0) continue;
+            const float v = p == 0 ? value(peak[c]) : (r.phase[peak[c]] + 3.14159265f) / 6.2831853f;
+            const ImVec2 q(p0.x + c + 0.5f, p1.y - std::clamp(v, 0.0f, 1.0f) * plotH);
+            if (c > 0 && peak[c - 1] >= 0) dl->AddLine(prev, q, colLine);
+            prev = q;
+        }
+        if (hovered) {
+            const int c = std::clamp((int)(ImGui::GetIO().MousePos.x - p0.x), 0, width - 1);
+            if (peak[c] >= 0) {
+                const int k = peak[c];
+                const float db = 20.0f * std::log10(std::max(r.magnitude[k], 1e-30f));
+                ImGui::SetTooltip("f = %.6g cycles/unit\n|X| = %.4g (%.1f dB)\nphase = %.3f rad",
+                    k * r.binWidth, r.magnitude[k], db, r.phase[k]);
+            }
+        }
+    }
+    ImGui::End();
+}
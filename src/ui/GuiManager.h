@@ -1,9 +1,12 @@
 #pragma once
 #include <imgui.h>
+#include "core/SpectrumAnalyzer.h"
 
 struct GLFWwindow;
 class RendererGL;
 class Scene;
+class Dashboard;
+class InputTrace;
 struct AppConfig;
 
 class GuiManager {
@@ -11,8 +14,23 @@ public:
     void Init(GLFWwindow* window, RendererGL& renderer);
     void Shutdown();
 
-    void BeginFrame();
+    // The trace replaces or records the frame's input around ImGui::NewFrame.
+    void BeginFrame(InputTrace& trace);
     void EndFrame(RendererGL& renderer);
 
-    void ShowMainMenu(AppConfig& cfg, Scene& scene);
+    void ShowMainMenu(AppConfig& cfg, Scene& scene, Dashboard& dashboard);
+    // Floating magnitude/phase plot of the explicit function's spectrum.
+    void ShowSpectrum(AppConfig& cfg, Scene& scene);
+
+private:
+    SpectrumAnalyzer::Result m_spectrum;
+
+    // Dashboard variant generator: panes of one template over a range of a.
+    char  m_variantExpr[256] = "sin(a*x)";
+    float m_variantFrom = 0.5f;
+    float m_variantTo = 4.0f;
+    int   m_variantCount = 16;
+    // Pane expression being typed; it reaches cfg.panes only on commit.
+    char  m_paneEdit[256] = ""; // DashboardPane::expr
+    int   m_paneEditing = -1;
 };
\ No newline at end of file